@@ -0,0 +1,88 @@
+// Copyright 2014, 2015 Stefano Sinigardi, Alessandro Fabbri
+// for any question, please mail stefano.sinigardi@gmail.com
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CHECKSUM_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+#define UBX_HEADER_SIZE   6
+#define UBX_FOOTER_SIZE   2
+
+
+/**
+* 8-bit Fletcher checksum, as used by the UBX protocol.
+* Blocks of 16 bytes are summed with SSE2 when available: over a block the
+* running sums become A' = A + sum(b_j) and B' = B + 16 A + sum((16 - j) b_j),
+* everything modulo 256, so the result is identical to the scalar loop.
+* \param data first byte covered by the checksum
+* \param len number of bytes covered
+* \param ck_a first checksum byte
+* \param ck_b second checksum byte
+*/
+void fletcher8(const unsigned char *data, size_t len, unsigned char &ck_a, unsigned char &ck_b){
+  uint32_t a = 0, b = 0;
+  size_t i = 0;
+
+#ifdef CHECKSUM_USE_SSE2
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i weights_lo = _mm_setr_epi16(16, 15, 14, 13, 12, 11, 10, 9);
+  const __m128i weights_hi = _mm_setr_epi16(8, 7, 6, 5, 4, 3, 2, 1);
+  for (; i + 16 <= len; i += 16) {
+    __m128i block = _mm_loadu_si128((const __m128i *)(data + i));
+    __m128i sum = _mm_sad_epu8(block, zero);
+    __m128i weighted = _mm_add_epi32(_mm_madd_epi16(_mm_unpacklo_epi8(block, zero), weights_lo),
+                                     _mm_madd_epi16(_mm_unpackhi_epi8(block, zero), weights_hi));
+    weighted = _mm_add_epi32(weighted, _mm_shuffle_epi32(weighted, _MM_SHUFFLE(1, 0, 3, 2)));
+    weighted = _mm_add_epi32(weighted, _mm_shuffle_epi32(weighted, _MM_SHUFFLE(2, 3, 0, 1)));
+    b += 16 * a + (uint32_t)_mm_cvtsi128_si32(weighted);
+    a += (uint32_t)_mm_cvtsi128_si32(sum) + (uint32_t)_mm_extract_epi16(sum, 4);
+  }
+#endif
+
+  for (; i < len; i++) {
+    a += data[i];
+    b += a;
+  }
+
+  ck_a = (unsigned char)a;
+  ck_b = (unsigned char)b;
+}
+
+
+/**
+* Check a complete UBX-framed message (0xB5 0x62 + class + id + uint16 length +
+* payload + CK_A + CK_B). The checksum covers class, id, length and payload.
+* \param frame first sync byte; the whole frame must be readable
+* \return true if the checksum bytes match
+*/
+bool ubx_frame_valid(const unsigned char *frame){
+  uint16_t length;
+  memcpy(&length, frame + 4, sizeof(length));
+  unsigned char ck_a, ck_b;
+  fletcher8(frame + 2, (size_t)length + 4, ck_a, ck_b);
+  return ck_a == frame[UBX_HEADER_SIZE + length] && ck_b == frame[UBX_HEADER_SIZE + length + 1];
+}
+
+
+/**
+* Validate a batch of complete UBX-framed messages in one pass.
+* \param frames first sync byte of each frame
+* \param count number of frames
+* \param valid output, set to 1 for each frame whose checksum matches and to 0 otherwise
+* \return number of valid frames
+*/
+size_t validate_ubx_frames(const unsigned char * const *frames, size_t count, unsigned char *valid){
+  size_t nvalid = 0;
+  for (size_t i = 0; i < count; i++) {
+    valid[i] = ubx_frame_valid(frames[i]) ? 1 : 0;
+    nvalid += valid[i];
+  }
+  return nvalid;
+}
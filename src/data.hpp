@@ -1,8 +1,63 @@
 #pragma once
 #include <array>
+#include <cstdint>
+
+#define RECORD_LAYOUT_FULL      1
+#define RECORD_LAYOUT_COMPACT   2
 
 struct Data{
   double d[7];
   void set(const std::array<double,6>&);
   void setAcc(const std::array<double,3>&);
 };
+
+/**
+* Sample of the unified format as shared through the rings: 56 bytes, so that
+* with its sequence number it fills one cache line. Angles and HDOP are stored
+* in fixed point, lat/lon with the 1e-7 degree resolution of the GPS receivers.
+*/
+struct Record{
+  typedef uint64_t Sequence;
+  static const uint32_t LAYOUT = RECORD_LAYOUT_FULL;
+
+  int64_t timestamp;      ///< Nanoseconds since the epoch (UTC)
+  int32_t lat;            ///< 1e-7 degrees
+  int32_t lon;            ///< 1e-7 degrees
+  float inertial[6];      ///< {ax, ay, az, gx, gy, gz}
+  float alt;              ///< m
+  float speed;            ///< m/s
+  uint16_t heading;       ///< 1e-2 degrees, 0 to 35999
+  uint16_t hdop;          ///< 1e-2
+  uint16_t valid;         ///< Bit POS_x set when field x holds a value
+  uint8_t quality;        ///< Fix quality as reported by the box
+  uint8_t reserved;
+
+  Record();
+  bool isSet(int pos) const;
+  double getLat() const;
+  double getLon() const;
+  double getHead() const;
+  double getHDOP() const;
+};
+
+/**
+* Inertial-only sample for rings that only feed plots: half the size of a Record.
+*/
+struct CompactRecord{
+  typedef uint32_t Sequence;
+  static const uint32_t LAYOUT = RECORD_LAYOUT_COMPACT;
+
+  uint32_t milliseconds;  ///< Timestamp in milliseconds, modulo 2^32
+  float inertial[6];      ///< {ax, ay, az, gx, gy, gz}
+
+  CompactRecord();
+  explicit CompactRecord(const Record&);
+
+  /**
+  * \return a Record holding the inertial values; the truncated time is not carried over
+  */
+  Record expand() const;
+};
+
+static_assert(sizeof(Record) == 56, "a Record and its sequence should fill one cache line");
+static_assert(sizeof(CompactRecord) == 28, "a CompactRecord and its sequence should fill half a cache line");
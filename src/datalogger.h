@@ -18,6 +18,17 @@
 
 #define DIMENSIONE_MAX 1000
 
+#define READ_CHUNK_SIZE     4096
+#define FILE_CHUNK_SIZE    65536
+#define SAMPLE_BATCH_SIZE    256
+#define MAX_LINE_SIZE        512
+#define UBX_MAX_PAYLOAD     1024
+#define RECORD_MAX_SIZE      512
+#define RECORD_SHORTEST       -1
+#define OUTPUT_BUFFER_SIZE  (1 << 20)
+#define FLUSH_EVERY_RECORDS 1000
+#define FLUSH_EVERY_MS      1000
+
 #include "version.h"
 
 #define EPOCH_TIME_2000 946684800
@@ -35,6 +46,27 @@
 #define UBX_ALT_OFFSET    36
 #define UBX_SPEED_OFFSET  60
 #define UBX_HEAD_OFFSET   60
+#define UBX_HEADMOT_OFFSET 64
+#define UBX_PDOP_OFFSET   76
+#define UBX_NAVPVT_LENGTH 92
+
+#define INFOMOBILITY_ACC_LENGTH 14
+#define INFOMOBILITY_GPS_LENGTH UBX_NAVPVT_LENGTH
+
+#define OCTO_INERTIAL_LENGTH  10
+#define OCTO_GPS_LENGTH       19
+#define OCTO_LATLON_SCALE     1e-7
+#define OCTO_HEADING_SCALE    (360.0 / 256.0)
+#define OCTO_SPEED_SCALE      (1.0 / 3.6)
+
+#define NMEA_MAX_FIELDS       32
+#define NMEA_KNOTS_TO_MS      (1852.0 / 3600.0)
+
+#define TEXA_FIELDS           21
+#define METASYSTEM_V2_FIELDS  18
+
+#define VIASAT_ACC_OFFSET      2
+#define VIASAT_ACC_WIDTH       6
 
 #define POS_TIME    0
 #define POS_AX      1
@@ -92,21 +124,11 @@
 #include <boost/system/error_code.hpp>
 #include <boost/thread.hpp>
 #include <boost/utility.hpp>
+#include <boost/utility/string_view.hpp>
 #include <array>
 #include "data.hpp"
 #include "shared_memory.hpp"
 
-#if defined(USE_HOST_MEMORY)
-#ifdef _WIN32
-#define BOOST_NO_RVALUE_REFERENCES
-#include <boost/interprocess/windows_shared_memory.hpp>
-#else
-#include <boost/interprocess/shared_memory_object.hpp>
-#endif
-#include <boost/interprocess/mapped_region.hpp>
-using namespace boost::interprocess;
-#endif
-
 
 
 
@@ -0,0 +1,1050 @@
+// Copyright 2014, 2015 Stefano Sinigardi, Alessandro Fabbri
+// for any question, please mail stefano.sinigardi@gmail.com
+
+#pragma once
+
+#include "data_tools.hpp"
+#include "checksum_tools.hpp"
+#include "number_tools.h"
+
+
+/**
+* Samples decoded during a feed() call.
+* Slots are reused between calls: clear() keeps the storage, so once the
+* batch has grown to the working size no further allocation happens.
+* Every sample pushed carries the arrival stamp of the chunk being decoded.
+*/
+class SampleBatch {
+  std::vector<NavData> samples;
+  size_t count;
+  ArrivalStamp arrival;
+public:
+  explicit SampleBatch(size_t capacity = SAMPLE_BATCH_SIZE);
+  void clear();
+  /**
+  * Stamp the samples pushed from now on, to be called when a chunk is read
+  */
+  void setArrival(const ArrivalStamp& stamp);
+  const ArrivalStamp& getArrival() const;
+  void push(const NavData& sample);
+  size_t size() const;
+  bool empty() const;
+  NavData& operator[](size_t index);
+  const NavData& operator[](size_t index) const;
+};
+
+SampleBatch::SampleBatch(size_t capacity) : samples(capacity), count(0) {}
+
+void SampleBatch::clear(){
+  count = 0;
+}
+
+void SampleBatch::setArrival(const ArrivalStamp& stamp){
+  arrival = stamp;
+}
+
+const ArrivalStamp& SampleBatch::getArrival() const {
+  return arrival;
+}
+
+void SampleBatch::push(const NavData& sample){
+  if (count < samples.size()) samples[count] = sample;
+  else samples.push_back(sample);
+  samples[count].setArrival(arrival);
+  count++;
+}
+
+size_t SampleBatch::size() const {
+  return count;
+}
+
+bool SampleBatch::empty() const {
+  return count == 0;
+}
+
+NavData& SampleBatch::operator[](size_t index){
+  return samples[index];
+}
+
+const NavData& SampleBatch::operator[](size_t index) const {
+  return samples[index];
+}
+
+//***************************************************************************************************************
+
+/**
+* Push-based decoder shared by the live and the offline tools.
+* Raw bytes are fed in chunks of any size, as they come from the serial port
+* or from a file; complete frames are turned into samples and appended to the
+* output batch, while an incomplete frame at the end of a chunk is kept and
+* completed by the next call.
+* Derived classes implement scan(), which works on a contiguous buffer: the
+* base class only copies bytes when a frame straddles two chunks.
+*/
+class FrameDecoder {
+public:
+  /**
+  * \param max_frame_size longest frame the decoder accepts, used to bound
+  * the bytes kept between two calls
+  */
+  explicit FrameDecoder(size_t max_frame_size);
+  virtual ~FrameDecoder() {}
+
+  /**
+  * Decode a chunk of raw bytes.
+  * \param data chunk start
+  * \param len chunk size
+  * \param out batch where decoded samples are appended
+  * \return number of samples appended
+  */
+  virtual size_t feed(const char *data, size_t len, SampleBatch& out);
+
+  /**
+  * Signal the end of the stream, decoding whatever is left if possible.
+  * \return number of samples appended
+  */
+  virtual size_t finish(SampleBatch& out);
+
+  /**
+  * Drop any partial frame and restart from a clean state
+  */
+  virtual void reset();
+
+  /**
+  * \return true if samples carry the device time, false if the caller has
+  * to stamp them with the host time
+  */
+  virtual bool hasOwnTime() const;
+
+  /**
+  * \return number of frames decoded since construction
+  */
+  size_t framesAccepted() const;
+
+  /**
+  * \return number of frame candidates discarded as corrupted since construction
+  */
+  size_t framesRejected() const;
+
+  /**
+  * \return number of frames the device sent but never reached the decoder,
+  * for protocols carrying a sequence number
+  */
+  size_t framesDropped() const;
+
+  /**
+  * \return number of well-formed frames of messages the decoder does not
+  * handle, such as proprietary NMEA sentences, since construction
+  */
+  size_t framesIgnored() const;
+
+protected:
+  /**
+  * Decode all the complete frames in [begin, end).
+  * \return number of bytes consumed; the remaining bytes must be the start
+  * of a frame not yet complete and will be presented again with more data
+  */
+  virtual size_t scan(const char *begin, const char *end, SampleBatch& out) = 0;
+
+  NavData navdata; ///< Record in unified format, updated frame by frame
+  size_t accepted;  ///< Frames decoded, updated by scan()
+  size_t rejected;  ///< Frames discarded, updated by scan()
+  size_t dropped;   ///< Frames missing from the sequence, updated by scan()
+  size_t ignored;   ///< Valid frames skipped as foreign, updated by scan()
+
+private:
+  std::vector<char> carry; ///< Incomplete frame left by the previous chunk
+  size_t max_frame_size;
+};
+
+FrameDecoder::FrameDecoder(size_t max_frame_size) : accepted(0), rejected(0), dropped(0), ignored(0), max_frame_size(max_frame_size) {
+  carry.reserve(2 * max_frame_size);
+}
+
+size_t FrameDecoder::feed(const char *data, size_t len, SampleBatch& out){
+  size_t before = out.size();
+
+  if (carry.size()) {
+    // complete the pending frame using only the bytes it can possibly need
+    size_t old_size = carry.size();
+    size_t take = std::min(len, max_frame_size);
+    carry.insert(carry.end(), data, data + take);
+    size_t used = scan(carry.data(), carry.data() + carry.size(), out);
+    if (used < old_size) {
+      if (take < len) carry.insert(carry.end(), data + take, data + len);
+      carry.erase(carry.begin(), carry.begin() + used);
+      return out.size() - before;
+    }
+    data += used - old_size;
+    len -= used - old_size;
+    carry.clear();
+  }
+
+  size_t used = scan(data, data + len, out);
+  carry.assign(data + used, data + len);
+
+  return out.size() - before;
+}
+
+size_t FrameDecoder::finish(SampleBatch& /*out*/){
+  carry.clear();
+  return 0;
+}
+
+void FrameDecoder::reset(){
+  carry.clear();
+  navdata = NavData();
+}
+
+bool FrameDecoder::hasOwnTime() const {
+  return false;
+}
+
+size_t FrameDecoder::framesAccepted() const {
+  return accepted;
+}
+
+size_t FrameDecoder::framesRejected() const {
+  return rejected;
+}
+
+size_t FrameDecoder::framesDropped() const {
+  return dropped;
+}
+
+size_t FrameDecoder::framesIgnored() const {
+  return ignored;
+}
+
+//***************************************************************************************************************
+
+/**
+* FrameDecoder for text protocols: frames are lines terminated by a delimiter,
+* a trailing '\r' is stripped before decoding.
+*/
+class LineDecoder : public FrameDecoder {
+public:
+  explicit LineDecoder(char delimiter = '\n', size_t max_line_size = MAX_LINE_SIZE);
+  virtual size_t finish(SampleBatch& out);
+protected:
+  virtual size_t scan(const char *begin, const char *end, SampleBatch& out);
+  /**
+  * Decode a single line, delimiter excluded, into navdata.
+  * \return true if navdata is a new sample
+  */
+  virtual bool decodeLine(const char *begin, const char *end) = 0;
+private:
+  char delimiter;
+  size_t max_line_size;
+};
+
+LineDecoder::LineDecoder(char delimiter, size_t max_line_size) : FrameDecoder(max_line_size), delimiter(delimiter), max_line_size(max_line_size) {}
+
+size_t LineDecoder::scan(const char *begin, const char *end, SampleBatch& out){
+  const char * p = begin;
+  const char * eol;
+  while ((eol = (const char *)memchr(p, delimiter, end - p)) != NULL) {
+    const char * last = eol;
+    if (last > p && last[-1] == '\r') last--;
+    if (decodeLine(p, last)) out.push(navdata);
+    p = eol + 1;
+  }
+  if ((size_t)(end - p) > max_line_size) p = end; // garbage without delimiter, drop it
+  return p - begin;
+}
+
+size_t LineDecoder::finish(SampleBatch& out){
+  return feed(&delimiter, 1, out);
+}
+
+//***************************************************************************************************************
+
+/**
+* Split a line into delimited fields without copying: fields are views into
+* the line, valid as long as the line buffer is. Only the first N fields are
+* kept, but all of them are counted.
+*/
+template<size_t N>
+class FieldSplitter {
+public:
+  FieldSplitter();
+  /**
+  * \return number of fields in [begin, end), possibly more than N
+  */
+  size_t split(const char *begin, const char *end, char delimiter);
+  /**
+  * \return number of fields found by the last split()
+  */
+  size_t size() const;
+  /**
+  * \return field i, empty if it does not exist or was not kept
+  */
+  boost::string_view operator[](size_t i) const;
+  /**
+  * \return pointer to the kept fields, to pass consecutive columns at once
+  */
+  const boost::string_view * data() const;
+private:
+  boost::string_view fields[N];
+  size_t count;
+};
+
+template<size_t N>
+FieldSplitter<N>::FieldSplitter() : count(0) {}
+
+template<size_t N>
+size_t FieldSplitter<N>::split(const char *begin, const char *end, char delimiter){
+  count = 0;
+  const char * p = begin;
+  for (;;) {
+    const char * next = (const char *)memchr(p, delimiter, end - p);
+    if (count < N) fields[count] = boost::string_view(p, (next ? next : end) - p);
+    count++;
+    if (!next) break;
+    p = next + 1;
+  }
+  return count;
+}
+
+template<size_t N>
+size_t FieldSplitter<N>::size() const {
+  return count;
+}
+
+template<size_t N>
+boost::string_view FieldSplitter<N>::operator[](size_t i) const {
+  return (i < count && i < N) ? fields[i] : boost::string_view();
+}
+
+template<size_t N>
+const boost::string_view * FieldSplitter<N>::data() const {
+  return fields;
+}
+
+/**
+* Parse numbers separated by runs of ';', ',' or ' '.
+* \param values parsed values
+* \param n maximum number of values to parse
+* \return number of values parsed before the first field that is not a number
+*/
+size_t parse_separated(const char *begin, const char *end, double *values, size_t n){
+  size_t count = 0;
+  const char * p = begin;
+  while (count < n) {
+    while (p != end && (*p == ';' || *p == ',' || *p == ' ')) p++;
+    if (p == end) break;
+    const char * q = p;
+    while (q != end && *q != ';' && *q != ',' && *q != ' ') q++;
+    if (parse_decimal(boost::string_view(p, q - p), values[count]) != numberOk) break;
+    count++;
+    p = q;
+  }
+  return count;
+}
+
+//***************************************************************************************************************
+
+/**
+* Read a value from an unaligned position of a little-endian stream
+*/
+template<typename T> T load_le(const unsigned char *p){
+  T value;
+  memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+/**
+* FrameDecoder for protocols using UBX framing: 0xB5 0x62 + class + id +
+* uint16 length + payload + 2 checksum bytes.
+* Complete frames in a chunk are located first and their checksums validated as
+* a batch; only valid frames reach decodeFrame(). The length of a corrupt frame
+* cannot be trusted, so the bytes following its sync characters are scanned
+* again, up to the next located frame that passed the checksum anyway: from
+* there the frames already validated are decoded as they are.
+*/
+class UbxFramedDecoder : public FrameDecoder {
+public:
+  explicit UbxFramedDecoder(size_t max_payload);
+protected:
+  virtual size_t scan(const char *begin, const char *end, SampleBatch& out);
+  /**
+  * \return true if a message with the given header may have this payload length
+  */
+  virtual bool validLength(unsigned char ubx_class, unsigned char ubx_id, uint16_t length) const = 0;
+  /**
+  * Decode the payload of a frame with a valid checksum into navdata.
+  * \return true if navdata is a new sample
+  */
+  virtual bool decodeFrame(unsigned char ubx_class, unsigned char ubx_id, const unsigned char *payload, uint16_t length) = 0;
+  /**
+  * Fill navdata time from a NAV-PVT payload
+  */
+  void decodeNavPvtTime(const unsigned char *payload);
+  /**
+  * Fill navdata from a NAV-PVT payload: fix type, position, ground speed,
+  * heading of motion and pDOP
+  */
+  void decodeNavPvtFix(const unsigned char *payload);
+private:
+  /**
+  * Locate, validate and decode the frames starting in [p, stop)
+  * \param last true if stop is the end of the chunk, so that a frame running past it is incomplete rather than corrupt
+  * \return where the scan stopped: the first byte not consumed
+  */
+  const unsigned char * scanFrames(const unsigned char *p, const unsigned char *stop, bool last, SampleBatch& out);
+
+  std::vector<const unsigned char *> frames; ///< Frames located in the current chunk
+  std::vector<unsigned char> valid;          ///< Checksum result for each frame
+};
+
+UbxFramedDecoder::UbxFramedDecoder(size_t max_payload) : FrameDecoder(max_payload + UBX_HEADER_SIZE + UBX_FOOTER_SIZE) {}
+
+size_t UbxFramedDecoder::scan(const char *begin, const char *end, SampleBatch& out){
+  const unsigned char * p = scanFrames((const unsigned char *)begin, (const unsigned char *)end, true, out);
+  return (const char *)p - begin;
+}
+
+const unsigned char * UbxFramedDecoder::scanFrames(const unsigned char *p, const unsigned char *stop, bool last, SampleBatch& out){
+  // the frames of this call are appended after those of the scan that called it, if any
+  const size_t base = frames.size();
+
+  for (;;) {
+    while (stop - p >= UBX_HEADER_SIZE) {
+      if (p[0] != 0xB5) {
+        p = (const unsigned char *)memchr(p + 1, 0xB5, stop - p - 1);
+        if (p == NULL) { p = stop; break; }
+        continue;
+      }
+      if (p[1] != 0x62) { p++; continue; }
+      uint16_t length = load_le<uint16_t>(p + 4);
+      if (!validLength(p[2], p[3], length)) { rejected++; p++; continue; }
+      if (stop - p < length + UBX_HEADER_SIZE + UBX_FOOTER_SIZE) {
+        if (last) break;
+        // it would overlap the frame that passed the checksum at stop
+        rejected++;
+        p++;
+        continue;
+      }
+      frames.push_back(p);
+      p += length + UBX_HEADER_SIZE + UBX_FOOTER_SIZE;
+    }
+    if (frames.size() == base) break;
+
+    valid.resize(frames.size());
+    validate_ubx_frames(frames.data() + base, frames.size() - base, valid.data() + base);
+
+    size_t i = base;
+    for (; i < frames.size(); i++) {
+      const unsigned char * f = frames[i];
+      if (valid[i]) {
+        if (decodeFrame(f[2], f[3], f + UBX_HEADER_SIZE, load_le<uint16_t>(f + 4))) out.push(navdata);
+        accepted++;
+        continue;
+      }
+      // corrupt frame: rescan right after its sync, up to the next frame that passed the checksum
+      rejected++;
+      size_t next = i + 1;
+      while (next < frames.size() && !valid[next]) next++;
+      if (next == frames.size()) break;
+      scanFrames(f + 1, frames[next], false, out);
+      i = next - 1;
+    }
+
+    bool done = i == frames.size();
+    if (!done) p = frames[i] + 1;
+    frames.resize(base);
+    valid.resize(base);
+    if (done) break;
+  }
+
+  return p;
+}
+
+void UbxFramedDecoder::decodeNavPvtTime(const unsigned char *payload){
+  // the nano field is signed and already includes the rounding of the second fields
+  navdata.setTimestamp(utc_nanoseconds(load_le<uint16_t>(payload + UBX_YEAR_OFFSET), payload[UBX_MONTH_OFFSET], payload[UBX_DAY_OFFSET],
+    payload[UBX_HOUR_OFFSET], payload[UBX_MIN_OFFSET], payload[UBX_SEC_OFFSET], load_le<int32_t>(payload + UBX_NANO_OFFSET)), 3);
+}
+
+void UbxFramedDecoder::decodeNavPvtFix(const unsigned char *payload){
+  navdata.setQlt((double)payload[UBX_FIX_OFFSET]);
+  navdata.setLon(load_le<int32_t>(payload + UBX_LON_OFFSET) * 1e-7);          // deg
+  navdata.setLat(load_le<int32_t>(payload + UBX_LAT_OFFSET) * 1e-7);          // deg
+  navdata.setAlt(load_le<int32_t>(payload + UBX_ALT_OFFSET) * 1e-3);          // m above mean sea level
+  navdata.setSpeed(load_le<int32_t>(payload + UBX_SPEED_OFFSET) * 1e-3);      // m/s
+  navdata.setHead(load_le<int32_t>(payload + UBX_HEADMOT_OFFSET) * 1e-5);     // deg
+  navdata.setHDOP(load_le<uint16_t>(payload + UBX_PDOP_OFFSET) * 1e-2);       // NAV-PVT only carries pDOP
+}
+
+//***************************************************************************************************************
+
+/**
+* UBX receivers: only NAV-PVT (class 0x01, id 0x07) produces a sample, other
+* messages are counted and skipped.
+*/
+class UbxDecoder : public UbxFramedDecoder {
+public:
+  UbxDecoder();
+  virtual bool hasOwnTime() const;
+protected:
+  virtual bool validLength(unsigned char ubx_class, unsigned char ubx_id, uint16_t length) const;
+  virtual bool decodeFrame(unsigned char ubx_class, unsigned char ubx_id, const unsigned char *payload, uint16_t length);
+};
+
+UbxDecoder::UbxDecoder() : UbxFramedDecoder(UBX_MAX_PAYLOAD) {}
+
+bool UbxDecoder::hasOwnTime() const {
+  return true;
+}
+
+bool UbxDecoder::validLength(unsigned char ubx_class, unsigned char ubx_id, uint16_t length) const {
+  if (ubx_class == 0x01 && ubx_id == 0x07) return length == UBX_NAVPVT_LENGTH;
+  return length <= UBX_MAX_PAYLOAD;
+}
+
+bool UbxDecoder::decodeFrame(unsigned char ubx_class, unsigned char ubx_id, const unsigned char *payload, uint16_t /*length*/){
+  if (ubx_class != 0x01 || ubx_id != 0x07) return false;
+  decodeNavPvtTime(payload);
+  decodeNavPvtFix(payload);
+  return true;
+}
+
+//***************************************************************************************************************
+
+/**
+* Infomobility boxes use UBX framing: 14-byte payloads carry the accelerometer
+* (int16 mg per axis), 92-byte payloads the GPS with the NAV-PVT layout.
+* Frames are decoded where they lie in the input chunk, so memory use does not
+* grow with the capture length. Samples are stamped with the host time, as the
+* accelerometer frames carry none.
+*/
+class InfomobilityDecoder : public UbxFramedDecoder {
+public:
+  InfomobilityDecoder();
+protected:
+  virtual bool validLength(unsigned char ubx_class, unsigned char ubx_id, uint16_t length) const;
+  virtual bool decodeFrame(unsigned char ubx_class, unsigned char ubx_id, const unsigned char *payload, uint16_t length);
+};
+
+InfomobilityDecoder::InfomobilityDecoder() : UbxFramedDecoder(INFOMOBILITY_GPS_LENGTH) {}
+
+bool InfomobilityDecoder::validLength(unsigned char /*ubx_class*/, unsigned char /*ubx_id*/, uint16_t length) const {
+  return length == INFOMOBILITY_ACC_LENGTH || length == INFOMOBILITY_GPS_LENGTH;
+}
+
+bool InfomobilityDecoder::decodeFrame(unsigned char /*ubx_class*/, unsigned char /*ubx_id*/, const unsigned char *payload, uint16_t length){
+  if (length == INFOMOBILITY_GPS_LENGTH) {
+    decodeNavPvtFix(payload);
+    return true;
+  }
+  double acc[3];
+  for (int i = 0; i < 3; i++) acc[i] = load_le<int16_t>(payload + 2 * i) / 1e3;
+  navdata.setAcc(acc);
+  return true;
+}
+
+//***************************************************************************************************************
+
+/**
+* MetaSystem frames: three 15-bit values, two bytes each, between 0xFF markers.
+* Decoded byte by byte with a small state machine kept across calls, so frames
+* split between two reads (or two CallbackAsyncSerial callbacks) are never
+* lost and no byte is ever copied.
+*/
+class MetasystemDecoder : public FrameDecoder {
+public:
+  MetasystemDecoder();
+  virtual size_t feed(const char *data, size_t len, SampleBatch& out);
+  virtual size_t finish(SampleBatch& out);
+  virtual void reset();
+protected:
+  virtual size_t scan(const char *begin, const char *end, SampleBatch& out);
+private:
+  bool synced;              ///< An 0xFF marker opened the current frame
+  size_t nbytes;            ///< Payload bytes collected since the marker
+  unsigned char frame[6];   ///< Payload of the current frame
+};
+
+MetasystemDecoder::MetasystemDecoder() : FrameDecoder(8), synced(false), nbytes(0) {}
+
+size_t MetasystemDecoder::feed(const char *data, size_t len, SampleBatch& out){
+  size_t before = out.size();
+  scan(data, data + len, out);
+  return out.size() - before;
+}
+
+size_t MetasystemDecoder::finish(SampleBatch& /*out*/){
+  synced = false;
+  nbytes = 0;
+  return 0;
+}
+
+void MetasystemDecoder::reset(){
+  FrameDecoder::reset();
+  synced = false;
+  nbytes = 0;
+}
+
+size_t MetasystemDecoder::scan(const char *begin, const char *end, SampleBatch& out){
+  const unsigned char align_char = 0xFF;
+
+  for (const unsigned char * p = (const unsigned char *)begin; p != (const unsigned char *)end; p++) {
+    if (*p == align_char) {
+      if (synced && nbytes == sizeof(frame)) {
+        raw data[3];
+        float acc[3];
+        for (int i = 0; i < 3; i++) {
+          data[i].value_ch[0] = frame[2 * i];
+          data[i].value_ch[1] = frame[2 * i + 1];
+          data[i].value_sh = (data[i].value_ush << 1);
+          acc[i] = ((float)data[i].value_sh) / 1e3f;
+        }
+        navdata.setAcc(acc);
+        out.push(navdata);
+        accepted++;
+      }
+      else if (synced && nbytes) rejected++;
+      synced = true; // closing marker opens the next frame
+      nbytes = 0;
+    }
+    else if (synced) {
+      if (nbytes < sizeof(frame)) frame[nbytes++] = *p;
+      else {
+        rejected++; // stream corrupted, not 0xFF terminated
+        synced = false;
+        nbytes = 0;
+      }
+    }
+  }
+
+  return end - begin;
+}
+
+//***************************************************************************************************************
+
+/**
+* Octo (and MagnetiMarelli_v2, its clone) fixed-length binary records:
+* "ACC"/"GYR" + id + 3 x int16, "GPS" + id + timestamp + nav + heading + speed + lat + lon.
+* The id byte counts records of each type, modulo 256: a jump in the sequence
+* is reported as dropped records. The GPS timestamp counts seconds since
+* 2000-01-01 UTC and dates the following inertial records too.
+*/
+class OctoDecoder : public FrameDecoder {
+public:
+  OctoDecoder();
+  virtual void reset();
+  virtual bool hasOwnTime() const;
+protected:
+  virtual size_t scan(const char *begin, const char *end, SampleBatch& out);
+private:
+  /**
+  * Update the sequence of a record type with a new id
+  */
+  void checkSequence(int type, unsigned char id);
+  int last_id[3]; ///< Last id seen for ACC, GYR and GPS records, -1 before the first one
+};
+
+OctoDecoder::OctoDecoder() : FrameDecoder(OCTO_GPS_LENGTH) {
+  std::fill(last_id, last_id + 3, -1);
+}
+
+void OctoDecoder::reset(){
+  FrameDecoder::reset();
+  std::fill(last_id, last_id + 3, -1);
+}
+
+bool OctoDecoder::hasOwnTime() const {
+  return true;
+}
+
+void OctoDecoder::checkSequence(int type, unsigned char id){
+  if (last_id[type] >= 0) dropped += (unsigned char)(id - last_id[type] - 1);
+  last_id[type] = id;
+}
+
+size_t OctoDecoder::scan(const char *begin, const char *end, SampleBatch& out){
+  const unsigned char * p = (const unsigned char *)begin;
+  const unsigned char * e = (const unsigned char *)end;
+
+  while (e - p >= 3) {
+    int type;
+    if (memcmp(p, "ACC", 3) == 0)      type = 0;
+    else if (memcmp(p, "GYR", 3) == 0) type = 1;
+    else if (memcmp(p, "GPS", 3) == 0) type = 2;
+    else { p++; continue; }
+
+    size_t record_size = (type == 2) ? OCTO_GPS_LENGTH : OCTO_INERTIAL_LENGTH;
+    if ((size_t)(e - p) < record_size) break;
+
+    checkSequence(type, p[3]);
+    if (type == 2) {
+      navdata.setTimestamp((EPOCH_TIME_2000 + (int64_t)load_le<uint32_t>(p + 4)) * NANOSECONDS_PER_SECOND, 0);
+      navdata.setQlt((double)p[8]);
+      navdata.setHead(p[9] * OCTO_HEADING_SCALE);
+      navdata.setSpeed(p[10] * OCTO_SPEED_SCALE);
+      navdata.setLat(load_le<int32_t>(p + 11) * OCTO_LATLON_SCALE);
+      navdata.setLon(load_le<int32_t>(p + 15) * OCTO_LATLON_SCALE);
+    }
+    else {
+      double data_temp[3];
+      for (size_t i = 0; i < 3; i++) data_temp[i] = load_le<int16_t>(p + 4 + 2 * i) / 1e3;
+      if (type == 0) navdata.setAcc(data_temp);
+      else           navdata.setGyr(data_temp);
+    }
+    out.push(navdata);
+    accepted++;
+    p += record_size;
+  }
+
+  return (const char *)p - begin;
+}
+
+//***************************************************************************************************************
+
+/**
+* MagnetiMarelli lines: "{ax;ay;az}" for the accelerometer, "gx;gy;gz" for the
+* gyroscope in 1/256 units
+*/
+class MagnetiMarelliDecoder : public LineDecoder {
+protected:
+  virtual bool decodeLine(const char *begin, const char *end);
+};
+
+bool MagnetiMarelliDecoder::decodeLine(const char *begin, const char *end){
+  if (begin == end) return false;
+  double values[3];
+  if (begin[0] == '{') {
+    const char * close = (const char *)memchr(begin, '}', end - begin);
+    if (parse_separated(begin + 1, close ? close : end, values, 3) < 3) return false;
+    navdata.setAcc(values);
+  }
+  else {
+    if (parse_separated(begin, end, values, 3) < 3) return false;
+    for (size_t i = 0; i < 3; i++) values[i] /= 256.;
+    navdata.setGyr(values);
+  }
+  return true;
+}
+
+
+/**
+* Texa lines: 21 ';' separated fields, the last 9 hold ax;ay;az;gx;gy;gz;...
+*/
+class TexaDecoder : public LineDecoder {
+  FieldSplitter<TEXA_FIELDS> fields;
+protected:
+  virtual bool decodeLine(const char *begin, const char *end);
+};
+
+bool TexaDecoder::decodeLine(const char *begin, const char *end){
+  if (fields.split(begin, end, ';') != TEXA_FIELDS || fields[0] == "Index") return false;
+  navdata.setInertial_s(fields.data() + TEXA_FIELDS - 9);
+  return true;
+}
+
+
+/**
+* ViaSat lines: "$A" + three fixed-width accelerometer fields in mg at
+* VIASAT_ACC_OFFSET, the last one ending at '*'; gyroscope lines have 'G'
+* as second character and their values between '{' and '}'
+*/
+class ViaSatDecoder : public LineDecoder {
+protected:
+  virtual bool decodeLine(const char *begin, const char *end);
+};
+
+bool ViaSatDecoder::decodeLine(const char *begin, const char *end){
+  if (end - begin < 2) return false;
+  double values[3];
+  if (begin[1] == 'G') {
+    const char * open = (const char *)memchr(begin, '{', end - begin);
+    const char * close = (const char *)memchr(begin, '}', end - begin);
+    if (parse_separated(open ? open + 1 : begin + 2, close ? close : end, values, 3) < 3) return false;
+    navdata.setGyr(values);
+  }
+  else {
+    if (end - begin < VIASAT_ACC_OFFSET + 2 * VIASAT_ACC_WIDTH + 1) return false;
+    const char * x = begin + VIASAT_ACC_OFFSET;
+    const char * star = (const char *)memchr(x, '*', end - x);
+    if (parse_decimal(boost::string_view(x, VIASAT_ACC_WIDTH), values[0]) != numberOk) return false;
+    if (parse_decimal(boost::string_view(x + VIASAT_ACC_WIDTH, VIASAT_ACC_WIDTH), values[1]) != numberOk) return false;
+    if (parse_decimal(boost::string_view(x + 2 * VIASAT_ACC_WIDTH, (star ? star : end) - x - 2 * VIASAT_ACC_WIDTH), values[2]) != numberOk) return false;
+    for (size_t i = 0; i < 3; i++) values[i] /= 1e3;
+    navdata.setAcc(values);
+  }
+  return true;
+}
+
+
+/**
+* Pack a two-letter NMEA talker ID (GP, GN, ...) for switch statements
+*/
+constexpr uint32_t nmea_talker(char a, char b){
+  return ((uint32_t)(unsigned char)a << 8) | (uint32_t)(unsigned char)b;
+}
+
+/**
+* Pack a three-letter NMEA sentence ID (RMC, GGA, ...) for switch statements
+*/
+constexpr uint32_t nmea_sentence(char a, char b, char c){
+  return ((uint32_t)(unsigned char)a << 16) | ((uint32_t)(unsigned char)b << 8) | (uint32_t)(unsigned char)c;
+}
+
+/**
+* \return value of an hexadecimal digit, -1 if c is not one
+*/
+int hex_value(char c){
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  return -1;
+}
+
+/**
+* NMEA 0183 sentences: $TTSSS,field,...*hh
+* Sentences are split in place into fields and checked against their checksum;
+* RMC, GGA, VTG and GSA update navdata, a sample is produced for every RMC and
+* dated with its UTC time and date.
+*/
+class NmeaDecoder : public LineDecoder {
+public:
+  NmeaDecoder();
+  virtual bool hasOwnTime() const;
+protected:
+  virtual bool decodeLine(const char *begin, const char *end);
+private:
+  /**
+  * \return true if field i is present and numeric, its value in value
+  */
+  bool number(size_t i, double& value) const;
+  /**
+  * \return first character of field i, 0 if empty or missing
+  */
+  char flag(size_t i) const;
+  /**
+  * \return latitude or longitude in degrees from a (d)ddmm.mmmm field and its hemisphere field
+  */
+  bool coordinate(size_t i, double& value) const;
+  /**
+  * \return true if fields time_field (hhmmss[.s...]) and date_field (ddmmyy) are valid,
+  * nanoseconds since the epoch and the number of decimals of the seconds in the other arguments
+  */
+  bool utcTime(size_t time_field, size_t date_field, int64_t& nanoseconds, int& decimals) const;
+  void decodeRmc();
+  void decodeGga();
+  void decodeVtg();
+  void decodeGsa();
+
+  FieldSplitter<NMEA_MAX_FIELDS> fields; ///< Sentence fields, '$' and checksum excluded
+};
+
+NmeaDecoder::NmeaDecoder() {}
+
+bool NmeaDecoder::hasOwnTime() const {
+  return true;
+}
+
+static bool nmea_digits(boost::string_view field, size_t pos, size_t count, unsigned int& value){
+  value = 0;
+  for (size_t i = pos; i < pos + count; i++) {
+    if (i >= field.size() || field[i] < '0' || field[i] > '9') return false;
+    value = value * 10 + (unsigned int)(field[i] - '0');
+  }
+  return true;
+}
+
+bool NmeaDecoder::number(size_t i, double& value) const {
+  return parse_decimal(fields[i], value) == numberOk;
+}
+
+char NmeaDecoder::flag(size_t i) const {
+  boost::string_view field = fields[i];
+  return field.empty() ? 0 : field[0];
+}
+
+bool NmeaDecoder::coordinate(size_t i, double& value) const {
+  double raw_value;
+  if (!number(i, raw_value)) return false;
+  double degrees = floor(raw_value / 100.);
+  value = degrees + (raw_value - 100. * degrees) / 60.;
+  char hemisphere = flag(i + 1);
+  if (hemisphere == 'S' || hemisphere == 'W') value = -value;
+  return true;
+}
+
+bool NmeaDecoder::utcTime(size_t time_field, size_t date_field, int64_t& nanoseconds, int& decimals) const {
+  boost::string_view time = fields[time_field], date = fields[date_field];
+  unsigned int hour, minute, second, day, month, year;
+  if (!nmea_digits(time, 0, 2, hour) || !nmea_digits(time, 2, 2, minute) || !nmea_digits(time, 4, 2, second)) return false;
+  if (!nmea_digits(date, 0, 2, day) || !nmea_digits(date, 2, 2, month) || !nmea_digits(date, 4, 2, year)) return false;
+  if (month < 1 || month > 12 || day < 1 || day > 31) return false;
+
+  int64_t fraction = 0, scale = NANOSECONDS_PER_SECOND;
+  decimals = 0;
+  if (time.size() > 6) {
+    if (time[6] != '.') return false;
+    for (size_t i = 7; i < time.size(); i++) {
+      if (time[i] < '0' || time[i] > '9') return false;
+      if (decimals == 9) continue;
+      scale /= 10;
+      fraction += (time[i] - '0') * scale;
+      decimals++;
+    }
+  }
+  nanoseconds = utc_nanoseconds(2000 + year, month, day, hour, minute, second, fraction);
+  return true;
+}
+
+void NmeaDecoder::decodeRmc(){
+  // time, status, lat, N/S, lon, E/W, speed [kn], course [deg], date, ...
+  int64_t nanoseconds;
+  int decimals;
+  if (utcTime(1, 9, nanoseconds, decimals)) navdata.setTimestamp(nanoseconds, decimals);
+  if (flag(2) != 'A') {
+    // void fix: drop the position of the previous one instead of repeating it
+    navdata.unset(POS_LAT);
+    navdata.unset(POS_LON);
+    navdata.unset(POS_SPEED);
+    navdata.unset(POS_HEAD);
+    return;
+  }
+  double value;
+  if (coordinate(3, value)) navdata.setLat(value);
+  if (coordinate(5, value)) navdata.setLon(value);
+  if (number(7, value)) navdata.setSpeed(value * NMEA_KNOTS_TO_MS);
+  if (number(8, value)) navdata.setHead(value);
+}
+
+void NmeaDecoder::decodeGga(){
+  // time, lat, N/S, lon, E/W, quality, satellites, HDOP, altitude, M, ...
+  double value;
+  if (!number(6, value)) return;
+  navdata.setQlt(value);
+  if (value == 0.) {
+    // no fix, position fields are empty or stale
+    navdata.unset(POS_LAT);
+    navdata.unset(POS_LON);
+    navdata.unset(POS_ALT);
+    navdata.unset(POS_HDOP);
+    return;
+  }
+  if (coordinate(2, value)) navdata.setLat(value);
+  if (coordinate(4, value)) navdata.setLon(value);
+  if (number(8, value)) navdata.setHDOP(value);
+  if (number(9, value)) navdata.setAlt(value);
+}
+
+void NmeaDecoder::decodeVtg(){
+  // course true, T, course magnetic, M, speed [kn], N, speed [km/h], K, ...
+  double value;
+  if (number(1, value)) navdata.setHead(value);
+  if (number(7, value)) navdata.setSpeed(value / 3.6);
+}
+
+void NmeaDecoder::decodeGsa(){
+  // mode, fix type, 12 x satellite, PDOP, HDOP, VDOP
+  double value;
+  if (number(16, value)) navdata.setHDOP(value);
+}
+
+bool NmeaDecoder::decodeLine(const char *begin, const char *end){
+  const char * start = (const char *)memchr(begin, '$', end - begin);
+  if (start == NULL) return false;
+  start++;
+  const char * star = (const char *)memchr(start, '*', end - start);
+  if (star == NULL || end - star < 3) { rejected++; return false; }
+
+  unsigned char checksum = 0;
+  for (const char * p = start; p != star; p++) checksum ^= (unsigned char)*p;
+  int hi = hex_value(star[1]), lo = hex_value(star[2]);
+  if (hi < 0 || lo < 0 || (hi << 4 | lo) != checksum) { rejected++; return false; }
+
+  fields.split(start, star, ',');
+  boost::string_view id = fields[0];
+  // proprietary ($PUBX, $PGRME...) and other talkers' sentences are well formed, just not ours
+  if (id.size() != 5) { ignored++; return false; }
+  switch (nmea_talker(id[0], id[1])) {
+  case nmea_talker('G', 'P'):
+  case nmea_talker('G', 'N'):
+  case nmea_talker('G', 'L'):
+  case nmea_talker('G', 'A'):
+  case nmea_talker('G', 'B'):
+  case nmea_talker('B', 'D'):
+    break;
+  default:
+    ignored++;
+    return false;
+  }
+  accepted++;
+
+  switch (nmea_sentence(id[2], id[3], id[4])) {
+  case nmea_sentence('R', 'M', 'C'): decodeRmc(); return true;
+  case nmea_sentence('G', 'G', 'A'): decodeGga(); return false;
+  case nmea_sentence('V', 'T', 'G'): decodeVtg(); return false;
+  case nmea_sentence('G', 'S', 'A'): decodeGsa(); return false;
+  default: return false;
+  }
+}
+
+
+/**
+* MetaSystem_v2 lines: utcTime;nano;lat;lon;tV;fV;pdop;spd(mms);head;ax;ay;az;gx;gy;gz;cnt;rtctime
+*/
+class MetasystemV2Decoder : public LineDecoder {
+  FieldSplitter<METASYSTEM_V2_FIELDS> fields;
+public:
+  virtual bool hasOwnTime() const;
+protected:
+  virtual bool decodeLine(const char *begin, const char *end);
+};
+
+bool MetasystemV2Decoder::hasOwnTime() const {
+  return true;
+}
+
+bool MetasystemV2Decoder::decodeLine(const char *begin, const char *end){
+  size_t nfields = fields.split(begin, end, ';');
+  if (!((BYPASS_CHECK && (nfields > 14)) || ((nfields == METASYSTEM_V2_FIELDS) && (fields[0] != "utcTime")))) return false;
+
+  float acc[3], gyro[3];
+  for (int i = 0; i < 3; i++) {
+    acc[i] = (float)(decimal_or_zero(fields[9 + i]) / 1000.);
+    gyro[i] = (float)(decimal_or_zero(fields[12 + i]) / 60.);
+  }
+  navdata.setAcc(acc);
+  navdata.setGyr(gyro);
+
+  int64_t seconds, nano;
+  if (parse_integer(fields[0].data(), fields[0].data() + fields[0].size(), seconds) == numberOk &&
+      parse_integer(fields[1].data(), fields[1].data() + fields[1].size(), nano) == numberOk)
+    navdata.setTimestamp(seconds * NANOSECONDS_PER_SECOND + nano, 3);
+  else navdata.setTime_s(fields[0]);
+  return true;
+}
+
+//***************************************************************************************************************
+
+std::vector<std::string> get_box_types(){
+  return std::vector<std::string>({ "Infomobility", "MagnetiMarelli", "Texa", "ViaSat", "MetaSystem", "UBX", "Octo", "NMEA", "MagnetiMarelli_v2", "MetaSystem_v2" });
+}
+
+/**
+* Build the decoder for a box type.
+* \param box_type 1-based index in get_box_types(), as given on the command line
+* \return the decoder, empty if the box type is unknown
+*/
+boost::shared_ptr<FrameDecoder> make_decoder(size_t box_type){
+  switch (box_type) {
+  case 1:  return boost::shared_ptr<FrameDecoder>(new InfomobilityDecoder());
+  case 2:  return boost::shared_ptr<FrameDecoder>(new MagnetiMarelliDecoder());
+  case 3:  return boost::shared_ptr<FrameDecoder>(new TexaDecoder());
+  case 4:  return boost::shared_ptr<FrameDecoder>(new ViaSatDecoder());
+  case 5:  return boost::shared_ptr<FrameDecoder>(new MetasystemDecoder());
+  case 6:  return boost::shared_ptr<FrameDecoder>(new UbxDecoder());
+  case 7:  return boost::shared_ptr<FrameDecoder>(new OctoDecoder());
+  case 8:  return boost::shared_ptr<FrameDecoder>(new NmeaDecoder());
+  case 9:  return boost::shared_ptr<FrameDecoder>(new OctoDecoder());
+  case 10: return boost::shared_ptr<FrameDecoder>(new MetasystemV2Decoder());
+  default: return boost::shared_ptr<FrameDecoder>();
+  }
+}
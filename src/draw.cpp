@@ -2,11 +2,11 @@
 // for any question, please mail stefano.sinigardi@gmail.com
 
 #include "draw.h"
+#include "shared_channel.h"
 
 #define NUMERO_SCATOLETTE 9
 
-Data **data;
-int *indiceData;
+std::vector<SharedChannel> channels;
 extern int tt;
 
 //#include "FL/fl_types.h"
@@ -64,13 +64,18 @@ void drawAcc() {
     glVertex3d(5.0, -5.0 + k, 0.0);
     glEnd();
   }
-  double dt = 5.0 / (DIMENSIONE_MAX - tt);
+  static std::vector<Record> window(DIMENSIONE_MAX);
+  size_t points = DIMENSIONE_MAX - tt;
+  double dt = 5.0 / points;
   for (int i = 0; i < NUMERO_SCATOLETTE; i++) {
+    // a consistent copy of the newest samples, aligned to the right edge
+    uint64_t first;
+    size_t n = channels[i].readLatest(window.data(), points, first);
     //fl_color(colornames[i]);
     glColor3d(colorvalues[i][0], colorvalues[i][1], colorvalues[i][2]);
     glBegin(GL_LINE_STRIP);
-    for (int k = tt; k < DIMENSIONE_MAX; k++)
-      glVertex3d((k - tt)*dt, data[i][(k + indiceData[i] + 1) % DIMENSIONE_MAX].d[3], 0.1);
+    for (size_t k = 0; k < n; k++)
+      if (window[k].isSet(POS_AZ)) glVertex3d((k + points - n)*dt, window[k].inertial[POS_AZ - POS_AX], 0.1);
     glEnd();
   }
 
@@ -82,9 +87,6 @@ void drawAcc() {
 void draw_scene(void){
 
   glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-  for (int i = 0; i < NUMERO_SCATOLETTE; i++) {
-    indiceData[i] = int(data[i][DIMENSIONE_MAX].d[0] + 0.333);
-  }
   glPushMatrix();
   drawAcc();
   glPopMatrix();
@@ -1,7 +1,9 @@
 // Copyright 2014, 2015 Stefano Sinigardi, Alessandro Fabbri
 // for any question, please mail stefano.sinigardi@gmail.com
 
-#include "data_tools.hpp"
+#include "decoder_tools.hpp"
+#include "output_tools.h"
+#include "shared_channel.h"
 
 
 int main(int argc, char ** argv)
@@ -9,7 +11,7 @@ int main(int argc, char ** argv)
   std::string filename;
   size_t systeminfo = 0;
   std::ifstream datafile;
-  std::vector<std::string> box_types({ "Infomobility", "MagnetiMarelli", "Texa", "ViaSat", "MetaSystem", "UBX", "Octo", "NMEA", "MagnetiMarelli_v2" });
+  std::vector<std::string> box_types = get_box_types();
 
   std::cout << "Datalogger v" << MAJOR_VERSION << "." << MINOR_VERSION << std::endl;
   std::cout << "Usage: " << argv[0] << " -f [filename] -t [box_type] -h (shows help and quit)" << std::endl;
@@ -62,588 +64,101 @@ int main(int argc, char ** argv)
     }
   }
 
-  NavData navdata;
-  int indiceData = 0;
-  size_t counter = 0;
   bool exit = false;
   std::ofstream logfile;
 
-  logfile.open(box_types[systeminfo - 1] + ".log", std::ofstream::out);
-
-#if defined (USE_HOST_MEMORY)
-  Data *data;
-  data = (Data*)get_host_allocated_memory(box_types[systeminfo - 1].c_str());
-#endif
-
-  if (systeminfo == 1) //Infomobility
-  {
-    InfomobilityData dato;
-
-    datafile.open(filename.c_str(), std::ios::in | std::ios::binary);
-    if (datafile.fail()) {
-      std::cout << "Unable to open file" << std::endl;
-      std::exit(5);
-    }
-
-    try {
-
-      while (exit == false)
-      {
-#ifdef _WIN32
-        if (GetAsyncKeyState(VK_ESCAPE))
-#elif __APPLE__
-        if (getc_unlocked(stdin) == 'q')   
-#else
-        if (fgetc_unlocked(stdin) == 'q')  // da implementare con fgetc_unlocked, questo e' solo un tentativo alla cieca, non so come funzioni!
-#endif
-        {
-          exit = true;
-        }
+  install_shutdown_handler();
 
-        dato.loadheader(datafile);
-        if (datafile.eof()) break;
-        dato.allocatePayload(dato.getPayloadSize());
-
-        dato.readPayload(datafile);
-        if (datafile.eof()) break;
-
-        dato.loadfooter(datafile);
-        if (datafile.eof()) break;
-
-        dato.checkfooter();
-        //dato.printheader();
-        //dato.printfooter();
-        dato.saveheader(logfile);
-        dato.savefooter(logfile);
-        //dato.deAllocatePayload();
-        if (dato.isGPSData())
-        {
-          dato.recordGPSDataFromPayload();
-#ifdef WRITE_ON_STDOUT
-          dato.printGPSData();
-#else
-          dato.saveGPSData(logfile);
-#endif
-        }
-        else
-        {
-          dato.recordACCDataFromPayload();
-#ifdef WRITE_ON_STDOUT
-          dato.printACCData();
-#else
-          dato.saveACCData(logfile);
-#endif
-        }
-      }
+  boost::shared_ptr<FrameDecoder> decoder = make_decoder(systeminfo);
+  if (!decoder) {
+    std::cout << "Error: unidentified object #" << systeminfo << std::endl;
+    return 1;
   }
 
-    catch (boost::system::system_error& e)
-    {
-      std::cout << "Error: " << e.what() << std::endl;
-      return 1;
-    }
-}
-
-  else if (systeminfo == 2) //MagnetiMarelli
-  {
-    datafile.open(filename.c_str(), std::ios::in);
-    if (datafile.fail()) {
-      std::cout << "Unable to open file" << std::endl;
-      std::exit(5);
-    }
-
-    try {
-      std::string sst;
-      std::vector<std::string> strs;
-
-      while (exit == false)
-      {
-#ifdef _WIN32
-        if (GetAsyncKeyState(VK_ESCAPE))
-#elif __APPLE__
-        if (getc_unlocked(stdin) == 'q')   
-#else
-        if (fgetc_unlocked(stdin) == 'q')  // da implementare con fgetc_unlocked, questo e' solo un tentativo alla cieca, non so come funzioni!
-#endif
-        {
-          exit = true;
-        }
-
-        std::getline(datafile, sst);
-        if (datafile.eof()) break;
-
-        if (sst[0] == '{')
-        {
-          boost::algorithm::split(strs, sst, boost::algorithm::is_any_of("{}; "));
-          navdata.setAcc_s(&strs[0]);
-#ifdef WRITE_ON_STDOUT
-          std::cout << navdata.to_string() << std::endl;
-#else
-          logfile << navdata.to_string() << std::endl;
-#endif
-        }
-        else
-        {
-          boost::algorithm::split(strs, sst, boost::algorithm::is_any_of("; "));
-          double gyr_data[3];
-          for (size_t i = 0; i < strs.size(); i++) gyr_data[i] = atof(strs[i].c_str()) / 256.;
-          navdata.setGyr(gyr_data);
-#ifdef WRITE_ON_STDOUT
-          std::cout << navdata.to_string() << std::endl;
-#else
-          logfile << navdata.to_string() << std::endl;
-#endif
-        }
-        break;
-
-#if defined (USE_HOST_MEMORY)
-        if (navdata.getAcc_s()[2].size()) {
-          data[indiceData].d[0] = (double)counter++;
-          data[indiceData].set(navdata.getInertial());
-          indiceData = (indiceData + 1) % DIMENSIONE_MAX;
-        }
-#endif
-        }
-      }
-    catch (boost::system::system_error& e)
-    {
-      std::cout << "Error: " << e.what() << std::endl;
-      return 1;
-    }
-    }
-
-
-  else if (systeminfo == 3) // Texa
-  {
-    datafile.open(filename.c_str(), std::ios::in);
-    if (datafile.fail()) {
-      std::cout << "Unable to open file" << std::endl;
-      std::exit(5);
-    }
-
-    try {
-      std::string sst;
-      std::vector<std::string> strs;
-
-      while (exit == false)
-      {
-#ifdef _WIN32
-        if (GetAsyncKeyState(VK_ESCAPE))
-#elif __APPLE__
-        if (getc_unlocked(stdin) == 'q')   
-#else
-        if (fgetc_unlocked(stdin) == 'q')  // da implementare con fgetc_unlocked, questo e' solo un tentativo alla cieca, non so come funzioni!
-#endif
-        {
-          exit = true;
-        }
-
-        std::getline(datafile, sst);
-        if (datafile.eof()) break;
-
-        boost::algorithm::split(strs, sst, boost::algorithm::is_any_of(";"));
-        if (strs.size() == 21) navdata.setInertial_s(&strs[strs.size() - 9]);
-
-#ifdef WRITE_ON_STDOUT
-        std::cout << navdata.to_string() << std::endl;
-#else
-        logfile << navdata.to_string() << std::endl;
-#endif
-
-#if defined (USE_HOST_MEMORY)
-        if (navdata.getAcc_s()[2].size()) {
-          data[indiceData].d[0] = (double)counter++;
-          data[indiceData].set(navdata.getInertial());
-          indiceData = (indiceData + 1) % DIMENSIONE_MAX;
-        }
-#endif
-        }
-      }
-    catch (boost::system::system_error& e)
-    {
-      std::cout << "Error: " << e.what() << std::endl;
-      return 1;
-    }
-    }
-
-  else if (systeminfo == 4) // ViaSat
-  {
-    datafile.open(filename.c_str(), std::ios::in);
-    if (datafile.fail()) {
-      std::cout << "Unable to open file" << std::endl;
-      std::exit(5);
-    }
-
-    try {
-      std::string sst;
-      std::vector<std::string> strs;
-
-      while (exit == false)
-      {
-#ifdef _WIN32
-        if (GetAsyncKeyState(VK_ESCAPE))
-#elif __APPLE__
-        if (getc_unlocked(stdin) == 'q')   
-#else
-        if (fgetc_unlocked(stdin) == 'q')  // da implementare con fgetc_unlocked, questo e' solo un tentativo alla cieca, non so come funzioni!
-#endif
-        {
-          exit = true;
-        }
-
-        std::getline(datafile, sst);
-        if (datafile.eof()) break;
-
-        if (sst[1] == 'G')
-        {
-          boost::algorithm::split(strs, sst, boost::algorithm::is_any_of("{}; "));
-
-          navdata.setAcc_s(&strs[0]);
-
-#ifdef WRITE_ON_STDOUT
-          std::cout << navdata.to_string() << std::endl;
-#else
-          logfile << navdata.to_string() << std::endl;
-#endif
-        }
-        else
-        {
-          sst.insert(8, " ", 1);
-          sst.insert(15, " ", 1);
-          boost::algorithm::split(strs, sst, boost::algorithm::is_any_of("$A* "));
-
-          double data_temp[3];
-          for (size_t i = 0; i < 3; i++) data_temp[i] = atof(strs[i].c_str()) / 1e3;
-          navdata.setAcc(data_temp);
-
-#ifdef WRITE_ON_STDOUT
-          std::cout << navdata.to_string() << std::endl;
-#else
-          logfile << navdata.to_string() << std::endl;
-#endif
-        }
-
-#if defined (USE_HOST_MEMORY)
-        if (navdata.getAcc_s()[2].size()) {
-          data[indiceData].d[0] = (double)counter++;
-          data[indiceData].set(navdata.getInertial());
-          indiceData = (indiceData + 1) % DIMENSIONE_MAX;
-        }
-#endif
-      }
-    }
-    catch (boost::system::system_error& e)
-    {
-      std::cout << "Error: " << e.what() << std::endl;
-      return 1;
-    }
+  datafile.open(filename.c_str(), std::ios::in | std::ios::binary);
+  if (datafile.fail()) {
+    std::cout << "Unable to open file" << std::endl;
+    std::exit(5);
   }
 
-  else if (systeminfo == 5) // MetaSystem
-  {
-    MetasystemData dato;
-    datafile.open(filename.c_str(), std::ios::in | std::ios::binary);
-    if (datafile.fail()) {
-      std::cout << "Unable to open file" << std::endl;
-      std::exit(5);
-    }
-
-    try {
-
-      while (exit == false)
-      {
-#ifdef _WIN32
-        if (GetAsyncKeyState(VK_ESCAPE))
-#elif __APPLE__
-        if (getc_unlocked(stdin) == 'q')   
-#else
-        if (fgetc_unlocked(stdin) == 'q')  // da implementare con fgetc_unlocked, questo e' solo un tentativo alla cieca, non so come funzioni!
-#endif
-        {
-          exit = true;
-        }
-
-        dato.readData(datafile, 1);
-        if (datafile.eof()) break;
-
-        for (size_t i = 0; i < dato.acc_v.size(); i++) {
-          navdata.setAcc(&dato.acc_v[i][0]);
-
-#ifdef WRITE_ON_STDOUT
-          std::cout << navdata.to_string() << std::endl;
-#else
-          logfile << navdata.to_string() << std::endl;
-#endif
+  logfile.open(box_types[systeminfo - 1] + ".log", std::ofstream::out);
 
 #if defined (USE_HOST_MEMORY)
-          if (navdata.getAcc_s()[2].size()) {
-            data[indiceData].d[0] = (double)counter++;
-            data[indiceData].set(navdata.getInertial());
-            indiceData = (indiceData + 1) % DIMENSIONE_MAX;
-          }
-#endif
-        }
-        dato.acc_v.clear();
-        }
-      }
-
-    catch (boost::system::system_error& e)
-    {
-      std::cout << "Error: " << e.what() << std::endl;
-      return 1;
-    }
-  }
-
-
-  else if (systeminfo == 6) // UBX
-  {
-    GPSData dato;
-    datafile.open(filename.c_str(), std::ios::in | std::ios::binary);
-    if (datafile.fail()) {
-      std::cout << "Unable to open file" << std::endl;
-      std::exit(5);
-    }
-
-    try {
-
-      while (exit == false)
-      {
-#ifdef _WIN32
-        if (GetAsyncKeyState(VK_ESCAPE))
-#elif __APPLE__
-        if (getc_unlocked(stdin) == 'q')   
-#else
-        if (fgetc_unlocked(stdin) == 'q')  // da implementare con fgetc_unlocked, questo e' solo un tentativo alla cieca, non so come funzioni!
-#endif
-        {
-          exit = true;
-      }
-
-        dato.readData(datafile);
-        if (datafile.eof()) break;
-#ifdef WRITE_ON_STDOUT
-        std::cout << navdata.to_string() << std::endl;
-#else
-        logfile << navdata.to_string() << std::endl;
-#endif
-
+  SharedChannel channel;
+  try {
+    channel = SharedChannel(box_types[systeminfo - 1]);
   }
+  catch (std::exception& e) {
+    std::cout << "Error: " << e.what() << std::endl;
+    return 1;
   }
-    catch (boost::system::system_error& e)
-    {
-      std::cout << "Error: " << e.what() << std::endl;
-      return 1;
-    }
-  }
-
-  else if (systeminfo == 7) // Octo
-  {
-    OctoData dato;
-    datafile.open(filename.c_str(), std::ios::in | std::ios::binary);
-    if (datafile.fail()) {
-      std::cout << "Unable to open file" << std::endl;
-      std::exit(5);
-    }
-
-    try {
-
-      while (exit == false)
-      {
-#ifdef _WIN32
-        if (GetAsyncKeyState(VK_ESCAPE))
-#elif __APPLE__
-        if (getc_unlocked(stdin) == 'q')   
-#else
-        if (fgetc_unlocked(stdin) == 'q')  // da implementare con fgetc_unlocked, questo e' solo un tentativo alla cieca, non so come funzioni!
 #endif
-        {
-          exit = true;
-        }
-
-        dato.readData(datafile, 1);
-        if (datafile.eof()) break;
-
-        double data_temp[3];
-        switch (dato.type){
-        case '1':
-          for (size_t i = 0; i < 3; i++) data_temp[i] = dato.acc_data[i] / 1e3;
-          navdata.setAcc(data_temp);
-          break;
-        case '2':
-          for (size_t i = 0; i < 3; i++) data_temp[i] = dato.gyr_data[i] / 1e3;
-          navdata.setGyr(data_temp);
-          break;
-        case '3':
-          // TODO
-        default:
-          break;
-        }
 
+  std::vector<char> buffer(FILE_CHUNK_SIZE);
+  RecordSchema schema = RecordSchema::defaults();
+  TimeFormatter time_format;
+  char record[RECORD_MAX_SIZE];
+  SampleBatch batch;
 #ifdef WRITE_ON_STDOUT
-        std::cout << navdata.to_string() << std::endl;
+  RecordWriter writer(std::cout);
 #else
-        logfile << navdata.to_string() << std::endl;
-#endif
-
-
-#if defined (USE_HOST_MEMORY)
-        if (navdata.getAcc_s()[2].size()) {
-          data[indiceData].d[0] = (double)counter++;
-          data[indiceData].set(navdata.getInertial());
-          indiceData = (indiceData + 1) % DIMENSIONE_MAX;
-        }
+  RecordWriter writer(logfile);
 #endif
 
-        dato.data_v.clear();
-      }
-  }
+  try {
 
-    catch (boost::system::system_error& e)
+    while (exit == false)
     {
-      std::cout << "Error: " << e.what() << std::endl;
-      return 1;
-    }
-  }
-
-
-  else if (systeminfo == 8) // NMEA
-  {
-    GPSData dato;
-    datafile.open(filename.c_str(), std::ios::in);
-    if (datafile.fail()) {
-      std::cout << "Unable to open file" << std::endl;
-      std::exit(5);
-    }
-
-    std::vector<boost::regex> patterns;
-    //std::vector<std::string> pattern_names({ "GSV", "GLL", "RMC", "VTG", "GGA", "GSA" });
-    std::vector<std::string> pattern_names({ "RMC" });
-    for (auto i : pattern_names) patterns.push_back(boost::regex(i));
-
-    try {
-      std::string sst;
-      std::vector<std::string> strs;
-      int nterm = 0;
-      int indiceData = 0;
-      bool exit = false;
-      bool found = false;
-
-      while (exit == false)
-      {
 #ifdef _WIN32
-        if (GetAsyncKeyState(VK_ESCAPE))
+      if (GetAsyncKeyState(VK_ESCAPE))
 #elif __APPLE__
-        if (getc_unlocked(stdin) == 'q')   
+      if (getc_unlocked(stdin) == 'q')
 #else
-        if (fgetc_unlocked(stdin) == 'q')  // da implementare con fgetc_unlocked, questo e' solo un tentativo alla cieca, non so come funzioni!
+      if (fgetc_unlocked(stdin) == 'q')  // da implementare con fgetc_unlocked, questo e' solo un tentativo alla cieca, non so come funzioni!
 #endif
-        {
-          exit = true;
-        }
-
-        std::getline(datafile, sst);
-        if (datafile.eof()) break;
-
-        boost::algorithm::split(strs, sst, boost::algorithm::is_any_of(","));
-        found = false;
-        for (auto i : patterns) if (boost::regex_search(strs[0], i)) found = true;
-
-#ifdef WRITE_ON_STDOUT
-        std::cout << navdata.to_string() << std::endl;
-#else
-        logfile << navdata.to_string() << std::endl;
-#endif
-        }
-      }
-    catch (boost::system::system_error& e)
-    {
-      std::cout << "Error: " << e.what() << std::endl;
-      return 1;
-    }
-    }
-
-
-
-  else if (systeminfo == 9) // MagnetiMarelli_v2 //Octo-clone
-  {
-    OctoData dato;
-    datafile.open(filename.c_str(), std::ios::in | std::ios::binary);
-    if (datafile.fail()) {
-      std::cout << "Unable to open file" << std::endl;
-      std::exit(5);
-    }
-
-    try {
-
-      while (exit == false)
       {
-#ifdef _WIN32
-        if (GetAsyncKeyState(VK_ESCAPE))
-#elif __APPLE__
-        if (getc_unlocked(stdin) == 'q')   
-#else
-        if (fgetc_unlocked(stdin) == 'q')  // da implementare con fgetc_unlocked, questo e' solo un tentativo alla cieca, non so come funzioni!
-#endif
-        {
-          exit = true;
-        }
+        exit = true;
+      }
+      if (shutdown_requested()) {
+        exit = true;
+      }
 
-        dato.readData(datafile, 1);
-        if (datafile.eof()) break;
+      datafile.read(buffer.data(), buffer.size());
+      std::streamsize nread = datafile.gcount();
 
-        double data_temp[3];
-        switch (dato.type){
-        case '1':
-          for (size_t i = 0; i < 3; i++) data_temp[i] = dato.acc_data[i] / 1e3;
-          navdata.setAcc(data_temp);
-          break;
-        case '2':
-          for (size_t i = 0; i < 3; i++) data_temp[i] = dato.gyr_data[i] / 1e3;
-          navdata.setGyr(data_temp);
-          break;
-        case '3':
-          // TODO
-        default:
-          break;
-        }
+      batch.clear();
+      if (nread > 0) decoder->feed(buffer.data(), (size_t)nread, batch);
+      else {
+        decoder->finish(batch);
+        exit = true;
+      }
 
-#ifdef WRITE_ON_STDOUT
-        std::cout << navdata.to_string() << std::endl;
-#else
-        logfile << navdata.to_string() << std::endl;
-#endif
+      for (size_t i = 0; i < batch.size(); i++) {
+        NavData& navdata = batch[i];
 
+        writer.write(record, navdata.format(record, sizeof(record), schema, time_format));
 
 #if defined (USE_HOST_MEMORY)
-        if (navdata.getAcc_s()[2].size()) {
-          data[indiceData].d[0] = (double)counter++;
-          data[indiceData].set(navdata.getInertial());
-          indiceData = (indiceData + 1) % DIMENSIONE_MAX;
-        }
+        channel.push(navdata.toRecord());
 #endif
-
-        dato.data_v.clear();
       }
-  }
-
-    catch (boost::system::system_error& e)
-    {
-      std::cout << "Error: " << e.what() << std::endl;
-      return 1;
+#if defined (USE_HOST_MEMORY)
+      channel.publish();
+#endif
     }
   }
-
-
-
-  else
+  catch (std::exception& e)
   {
-    std::cout << "Error: unidentified object #" << systeminfo << std::endl;
+    writer.flush();
+    std::cout << "Error: " << e.what() << std::endl;
+    return 1;
   }
 
+  writer.flush();
+  std::cout << "Frames decoded: " << decoder->framesAccepted() << ", rejected: " << decoder->framesRejected() << ", dropped: " << decoder->framesDropped() << ", ignored: " << decoder->framesIgnored() << std::endl;
 
   logfile.close();
   datafile.close();
 
   return 0;
 }
-
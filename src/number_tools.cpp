@@ -0,0 +1,328 @@
+// Copyright 2014, 2015 Stefano Sinigardi, Alessandro Fabbri
+// for any question, please mail stefano.sinigardi@gmail.com
+
+#include "number_tools.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+
+static const double exact_powers_of_ten[] = {
+  1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static const int max_exact_power = 22;
+static const int max_mantissa_digits = 19;
+static const uint64_t max_exact_mantissa = (uint64_t)1 << 53;
+
+
+static bool is_blank(char c)
+{
+  return c == ' ' || c == '\t';
+}
+
+static bool is_digit(char c)
+{
+  return c >= '0' && c <= '9';
+}
+
+static void trim(const char *&begin, const char *&end)
+{
+  while (begin != end && is_blank(*begin)) begin++;
+  while (begin != end && is_blank(end[-1])) end--;
+}
+
+
+NumberStatus parse_integer(const char *begin, const char *end, int64_t &value)
+{
+  trim(begin, end);
+  if (begin == end) return numberEmpty;
+
+  const char *p = begin;
+  bool negative = (*p == '-');
+  if (*p == '-' || *p == '+') p++;
+  if (p == end) return numberInvalid;
+
+  const uint64_t limit = negative ? (uint64_t)std::numeric_limits<int64_t>::max() + 1 : (uint64_t)std::numeric_limits<int64_t>::max();
+  uint64_t magnitude = 0;
+  bool overflow = false;
+  for (; p != end; p++) {
+    if (!is_digit(*p)) return numberInvalid;
+    unsigned digit = (unsigned)(*p - '0');
+    if (magnitude > (limit - digit) / 10) overflow = true;
+    else magnitude = magnitude * 10 + digit;
+  }
+  if (overflow) return numberOutOfRange;
+
+  value = negative ? (int64_t)(0 - magnitude) : (int64_t)magnitude;
+  return numberOk;
+}
+
+
+NumberStatus parse_decimal(const char *begin, const char *end, double &value)
+{
+  trim(begin, end);
+  if (begin == end) return numberEmpty;
+
+  const char *p = begin;
+  bool negative = (*p == '-');
+  if (*p == '-' || *p == '+') p++;
+
+  uint64_t mantissa = 0;
+  int digits = 0;          // significant digits stored in mantissa
+  int exponent = 0;        // power of ten to apply to mantissa
+  bool any_digit = false;
+
+  for (; p != end && is_digit(*p); p++) {
+    any_digit = true;
+    if (digits < max_mantissa_digits) {
+      mantissa = mantissa * 10 + (uint64_t)(*p - '0');
+      if (mantissa) digits++;
+    }
+    else exponent++;       // digits beyond the precision only scale the value
+  }
+  if (p != end && *p == '.') {
+    for (p++; p != end && is_digit(*p); p++) {
+      any_digit = true;
+      if (digits < max_mantissa_digits) {
+        mantissa = mantissa * 10 + (uint64_t)(*p - '0');
+        if (mantissa) digits++;
+        exponent--;
+      }
+    }
+  }
+  if (!any_digit) return numberInvalid;
+
+  if (p != end && (*p == 'e' || *p == 'E')) {
+    p++;
+    bool negative_exponent = (p != end && *p == '-');
+    if (p != end && (*p == '-' || *p == '+')) p++;
+    if (p == end || !is_digit(*p)) return numberInvalid;
+    int explicit_exponent = 0;
+    for (; p != end && is_digit(*p); p++) {
+      if (explicit_exponent < 100000) explicit_exponent = explicit_exponent * 10 + (*p - '0');
+    }
+    exponent += negative_exponent ? -explicit_exponent : explicit_exponent;
+  }
+  if (p != end) return numberInvalid;
+
+  double result;
+  if (mantissa == 0) result = 0.;
+  else if (mantissa <= max_exact_mantissa && exponent >= -max_exact_power && exponent <= max_exact_power) {
+    // both operands are exact doubles, so a single multiplication or division rounds correctly
+    result = (double)mantissa;
+    if (exponent < 0) result /= exact_powers_of_ten[-exponent];
+    else result *= exact_powers_of_ten[exponent];
+  }
+  else {
+    long double scaled = (long double)mantissa;
+    if (exponent < 0) scaled /= std::pow(10.0L, (long double)-exponent);
+    else scaled *= std::pow(10.0L, (long double)exponent);
+    result = (double)scaled;
+    if (std::isinf(result)) return numberOutOfRange;
+  }
+
+  value = negative ? -result : result;
+  return numberOk;
+}
+
+
+NumberStatus parse_decimal(boost::string_view text, double &value)
+{
+  return parse_decimal(text.data(), text.data() + text.size(), value);
+}
+
+
+double decimal_or_zero(boost::string_view text)
+{
+  double value;
+  return parse_decimal(text, value) == numberOk ? value : 0.;
+}
+
+
+static size_t format_printf(char *out, const char *format, int precision, double value)
+{
+  char buffer[NUMBER_FORMAT_MAX + 16];
+  int len = snprintf(buffer, sizeof(buffer), format, precision, value);
+  if (len < 0) return 0;
+  if (len > NUMBER_FORMAT_MAX) len = NUMBER_FORMAT_MAX;
+  memcpy(out, buffer, len);
+  return (size_t)len;
+}
+
+
+size_t format_fixed(char *out, double value, int decimals)
+{
+  if (decimals < 0) decimals = 0;
+  if (decimals > 15) decimals = 15;
+  double scaled = std::fabs(value) * exact_powers_of_ten[decimals];
+  if (!(scaled < 9e18)) return format_printf(out, "%.*f", decimals, value); // nan, inf, huge
+
+  uint64_t units = (uint64_t)(scaled + 0.5);
+  if (units == 0) {
+    out[0] = '0';
+    return 1;
+  }
+
+  // digits are produced backwards, fractional ones first, skipping trailing zeros
+  char digits[24];
+  char *p = digits + sizeof(digits);
+  int fraction = decimals;
+  while (fraction > 0 && units % 10 == 0) {
+    units /= 10;
+    fraction--;
+  }
+  if (fraction > 0) {
+    for (int i = 0; i < fraction; i++) {
+      *--p = (char)('0' + units % 10);
+      units /= 10;
+    }
+    *--p = '.';
+  }
+  do {
+    *--p = (char)('0' + units % 10);
+    units /= 10;
+  } while (units);
+  if (value < 0) *--p = '-';
+
+  size_t len = (size_t)(digits + sizeof(digits) - p);
+  memcpy(out, p, len);
+  return len;
+}
+
+
+// Significant digits of value, correctly rounded, and the decimal exponent of the
+// first one. Only the digits of printf's scientific notation are used: the
+// locale may change the decimal separator there, never the digits.
+// Asking for more digits than kept lets round_digits() round from the value
+// itself rather than from a rounding of it.
+static void scientific_digits(double value, int count, char *digits, int &exponent)
+{
+  char buffer[NUMBER_FORMAT_MAX + 16];
+  int len = snprintf(buffer, sizeof(buffer), "%.*e", count - 1, value);
+  const char *p = buffer, *end = buffer + (len > 0 ? std::min<int>(len, sizeof(buffer) - 1) : 0);
+  int n = 0;
+  for (; p != end && *p != 'e'; p++) {
+    if (is_digit(*p) && n < count) digits[n++] = *p;
+  }
+  while (n < count) digits[n++] = '0';
+  int64_t e = 0;
+  if (p != end) parse_integer(p + 1, end, e);
+  exponent = (int)e;
+}
+
+
+// Round count digits to precision, half to even as printf does; a carry out of
+// the first digit moves the exponent
+static void round_digits(const char *all, int count, int precision, char *digits, int &exponent)
+{
+  memcpy(digits, all, precision);
+  if (all[precision] < '5') return;
+  bool tie = all[precision] == '5';
+  for (int i = precision + 1; i < count && tie; i++) tie = all[i] == '0';
+  if (tie && (digits[precision - 1] - '0') % 2 == 0) return;
+  int i = precision - 1;
+  for (; i >= 0 && digits[i] == '9'; i--) digits[i] = '0';
+  if (i >= 0) digits[i]++;
+  else {
+    digits[0] = '1';
+    exponent++;
+  }
+}
+
+
+// Write the digits as %.*g would with this precision, trailing zeros removed, but always with '.'
+static size_t write_general(char *out, bool negative, const char *digits, int count, int exponent, int precision)
+{
+  while (count > 1 && digits[count - 1] == '0') count--;
+  char *p = out;
+  if (negative) *p++ = '-';
+  if (exponent < -4 || exponent >= precision) {
+    *p++ = digits[0];
+    if (count > 1) {
+      *p++ = '.';
+      memcpy(p, digits + 1, count - 1);
+      p += count - 1;
+    }
+    int e = exponent < 0 ? -exponent : exponent;
+    *p++ = 'e';
+    *p++ = exponent < 0 ? '-' : '+';
+    if (e >= 100) *p++ = (char)('0' + e / 100);
+    *p++ = (char)('0' + e / 10 % 10);
+    *p++ = (char)('0' + e % 10);
+  }
+  else if (exponent < 0) {
+    *p++ = '0';
+    *p++ = '.';
+    for (int i = -1; i > exponent; i--) *p++ = '0';
+    memcpy(p, digits, count);
+    p += count;
+  }
+  else {
+    for (int i = 0; i <= exponent; i++) *p++ = i < count ? digits[i] : '0';
+    if (count > exponent + 1) {
+      *p++ = '.';
+      memcpy(p, digits + exponent + 1, count - exponent - 1);
+      p += count - exponent - 1;
+    }
+  }
+  return (size_t)(p - out);
+}
+
+
+// Shortest text between min_precision and max_precision significant digits
+// reading back to value, as a float if single. Any text of min_precision
+// digits or less that reads back is the min_precision one, trimmed.
+static size_t format_round_trip(char *out, double value, int min_precision, int max_precision, bool single)
+{
+  if (std::isnan(value) || std::isinf(value)) return format_printf(out, "%.*g", max_precision, value);
+  bool negative = std::signbit(value);
+  double magnitude = std::fabs(value);
+
+  // short decimals, as sensors give, are found without printf: the text of n
+  // with d decimals reads back as n / 10^d, exactly as computed here
+  for (int d = 0; d <= max_exact_power; d++) {
+    double n = std::round(magnitude * exact_powers_of_ten[d]);
+    if (n >= exact_powers_of_ten[min_precision]) break;
+    double check = n / exact_powers_of_ten[d];
+    if (single ? (float)check != (float)magnitude : check != magnitude) continue;
+    char digits[24];
+    char *p = digits + sizeof(digits);
+    uint64_t units = (uint64_t)n;
+    do {
+      *--p = (char)('0' + units % 10);
+      units /= 10;
+    } while (units);
+    int count = (int)(digits + sizeof(digits) - p);
+    return write_general(out, negative, p, count, count - 1 - d, min_precision);
+  }
+
+  const int count = max_precision + 8;
+  char all[32], digits[32];
+  int exponent;
+  scientific_digits(magnitude, count, all, exponent);
+  for (int precision = min_precision; precision < max_precision; precision++) {
+    int rounded_exponent = exponent;
+    round_digits(all, count, precision, digits, rounded_exponent);
+    size_t len = write_general(out, negative, digits, precision, rounded_exponent, precision);
+    double check;
+    if (parse_decimal(out, out + len, check) == numberOk && (single ? (float)check == (float)value : check == value)) return len;
+  }
+  // enough digits to tell any two doubles, or floats, apart
+  round_digits(all, count, max_precision, digits, exponent);
+  return write_general(out, negative, digits, max_precision, exponent, max_precision);
+}
+
+
+size_t format_shortest(char *out, double value)
+{
+  return format_round_trip(out, value, 15, 17, false);
+}
+
+
+size_t format_shortest(char *out, float value)
+{
+  return format_round_trip(out, value, 6, 9, true);
+}
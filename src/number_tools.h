@@ -0,0 +1,81 @@
+// Copyright 2014, 2015 Stefano Sinigardi, Alessandro Fabbri
+// for any question, please mail stefano.sinigardi@gmail.com
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <boost/utility/string_view.hpp>
+
+/**
+* Outcome of a number conversion
+*/
+enum NumberStatus
+{
+  numberOk,         ///< The whole range is a number
+  numberEmpty,      ///< Nothing but blanks in the range
+  numberInvalid,    ///< Not a number, or followed by other characters
+  numberOutOfRange  ///< A number, but too large for the destination type
+};
+
+/**
+* Parse a signed decimal integer, [+-]digits, from a char range.
+* Leading and trailing blanks are skipped. The locale is never consulted.
+* \param begin first character
+* \param end one past the last character
+* \param value parsed value, written only when the result is numberOk
+* \return conversion outcome
+*/
+NumberStatus parse_integer(const char *begin, const char *end, int64_t &value);
+
+/**
+* Parse a decimal number, [+-]digits[.digits][(e|E)[+-]digits], from a char range.
+* Leading and trailing blanks are skipped and '.' is always the decimal
+* separator, whatever the locale. Up to 19 significant digits with a power
+* of ten within 1e22 are converted exactly; longer or larger numbers go
+* through long double arithmetic.
+* \param begin first character
+* \param end one past the last character
+* \param value parsed value, written only when the result is numberOk
+* \return conversion outcome
+*/
+NumberStatus parse_decimal(const char *begin, const char *end, double &value);
+NumberStatus parse_decimal(boost::string_view text, double &value);
+
+/**
+* Lenient conversion, for fields that may be empty
+* \return the parsed value, 0 if text is not a number
+*/
+double decimal_or_zero(boost::string_view text);
+
+/**
+* Longest text written by the format functions
+*/
+#define NUMBER_FORMAT_MAX 32
+
+/**
+* Write value rounded to a fixed number of decimals, trailing zeros removed
+* ("1.5" and not "1.500000", "2" and not "2.0"). The locale is never consulted.
+* \param out destination, at least NUMBER_FORMAT_MAX characters, not null terminated
+* \param value number to write
+* \param decimals decimals kept before trimming, 0 to 15
+* \return number of characters written
+*/
+size_t format_fixed(char *out, double value, int decimals);
+
+/**
+* Write the shortest text that parses back to exactly value, in the style of
+* printf's %g. Short decimals are written directly; other values take a
+* single printf call, for correctly rounded digits. '.' is always the
+* decimal separator, whatever the locale.
+* \param out destination, at least NUMBER_FORMAT_MAX characters, not null terminated
+* \return number of characters written
+*/
+size_t format_shortest(char *out, double value);
+
+/**
+* Write the shortest text that parses back to exactly value as a float
+* \param out destination, at least NUMBER_FORMAT_MAX characters, not null terminated
+* \return number of characters written
+*/
+size_t format_shortest(char *out, float value);
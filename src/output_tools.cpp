@@ -0,0 +1,94 @@
+// Copyright 2014, 2015 Stefano Sinigardi, Alessandro Fabbri
+// for any question, please mail stefano.sinigardi@gmail.com
+
+#include "output_tools.h"
+#include <csignal>
+
+FlushPolicy::FlushPolicy(size_t records, unsigned int milliseconds) : records(records), milliseconds(milliseconds) {}
+
+
+RecordWriter::RecordWriter(std::ostream& out, const FlushPolicy& policy, size_t buffer_size)
+  : out(out), policy(policy), buffer(buffer_size), used(0), records(0) {}
+
+RecordWriter::~RecordWriter()
+{
+  try {
+    flush();
+  }
+  catch (...) {}
+}
+
+void RecordWriter::write(const char *record, size_t len)
+{
+  if (used + len + 1 > buffer.size()) {
+    // the buffered records are handed to the stream, the policy starts again from this one
+    out.write(buffer.data(), used);
+    used = 0;
+    records = 0;
+    if (len + 1 > buffer.size()) {
+      // longer than the whole buffer, no point in copying it
+      out.write(record, len);
+      out.put('\n');
+      flush();
+      return;
+    }
+  }
+
+  if (records == 0) oldest = std::chrono::steady_clock::now();
+  memcpy(buffer.data() + used, record, len);
+  used += len;
+  buffer[used++] = '\n';
+  records++;
+
+  if (policy.records && records >= policy.records) flush();
+  else poll();
+}
+
+void RecordWriter::poll()
+{
+  if (!policy.milliseconds || !records) return;
+  if (std::chrono::steady_clock::now() - oldest >= std::chrono::milliseconds(policy.milliseconds)) flush();
+}
+
+void RecordWriter::flush()
+{
+  if (used) out.write(buffer.data(), used);
+  out.flush();
+  used = 0;
+  records = 0;
+}
+
+size_t RecordWriter::pending() const
+{
+  return records;
+}
+
+
+static volatile std::sig_atomic_t shutdown_signal = 0;
+
+static void on_shutdown_signal(int)
+{
+  shutdown_signal = 1;
+}
+
+void install_shutdown_handler()
+{
+#ifdef _WIN32
+  std::signal(SIGINT, on_shutdown_signal);
+  std::signal(SIGTERM, on_shutdown_signal);
+  std::signal(SIGBREAK, on_shutdown_signal);
+#else
+  // no SA_RESTART: a read blocked on stdin or on the port returns with EINTR
+  struct sigaction action;
+  memset(&action, 0, sizeof(action));
+  action.sa_handler = on_shutdown_signal;
+  sigemptyset(&action.sa_mask);
+  sigaction(SIGINT, &action, NULL);
+  sigaction(SIGTERM, &action, NULL);
+#endif
+}
+
+bool shutdown_requested()
+{
+  return shutdown_signal != 0;
+}
@@ -0,0 +1,84 @@
+// Copyright 2014, 2015 Stefano Sinigardi, Alessandro Fabbri
+// for any question, please mail stefano.sinigardi@gmail.com
+
+#pragma once
+
+#include "datalogger.h"
+#include <chrono>
+
+/**
+* When the records buffered by a RecordWriter are written out
+*/
+struct FlushPolicy
+{
+  /**
+  * \param records flush once this many records are buffered, 0 to disable
+  * \param milliseconds flush once the oldest buffered record is this old, 0 to disable
+  */
+  FlushPolicy(size_t records = FLUSH_EVERY_RECORDS, unsigned int milliseconds = FLUSH_EVERY_MS);
+
+  size_t records;
+  unsigned int milliseconds;
+};
+
+/**
+* Line-oriented writer for the sample logs.
+* Records are collected in a large buffer and handed to the stream in big
+* blocks according to the flush policy, instead of flushing the stream after
+* every line. Whatever is left is written by flush(), called by the destructor.
+* Not thread safe: a writer belongs to the thread that produces its records.
+*/
+class RecordWriter : private boost::noncopyable
+{
+public:
+  /**
+  * \param out destination stream, usually std::cout or the .log file
+  * \param policy when to flush
+  * \param buffer_size bytes buffered before a write is forced anyway
+  */
+  RecordWriter(std::ostream& out, const FlushPolicy& policy = FlushPolicy(), size_t buffer_size = OUTPUT_BUFFER_SIZE);
+  ~RecordWriter();
+
+  /**
+  * Append a record followed by a newline, flushing if the policy says so
+  * \param record record text, not null terminated
+  * \param len record length
+  */
+  void write(const char *record, size_t len);
+
+  /**
+  * Flush if the oldest buffered record is older than the policy allows.
+  * To be called periodically by loops that may go idle
+  */
+  void poll();
+
+  /**
+  * Write all the buffered records and flush the stream
+  */
+  void flush();
+
+  /**
+  * \return number of records not yet written to the stream
+  */
+  size_t pending() const;
+
+private:
+  std::ostream& out;
+  FlushPolicy policy;
+  std::vector<char> buffer;
+  size_t used;
+  size_t records;
+  std::chrono::steady_clock::time_point oldest;
+};
+
+/**
+* Catch SIGINT and SIGTERM (Ctrl-C and Ctrl-Break on Windows) so that the
+* tools can leave their loop and flush their output instead of dying with
+* records still buffered. Blocking reads are interrupted where the platform allows it.
+*/
+void install_shutdown_handler();
+
+/**
+* \return true once a shutdown signal has been received
+*/
+bool shutdown_requested();
@@ -0,0 +1,264 @@
+// Copyright 2014, 2015 Stefano Sinigardi, Alessandro Fabbri
+// for any question, please mail stefano.sinigardi@gmail.com
+
+#pragma once
+
+#include "datalogger.h"
+#include "serial_tools.h"
+#include "decoder_tools.hpp"
+#include "output_tools.h"
+#include "shared_channel.h"
+#include <climits>
+
+#define PORT_POLL_MS 100    // how often the multi-port loop flushes idle writers and checks for shutdown
+
+
+/**
+* Where the samples of one box go: the text log, through a RecordWriter, and
+* the shared ring named after the box. Also keeps the ingest latency, from the
+* read that completed a batch to its records handed to the writer.
+*/
+class SampleSink : private boost::noncopyable {
+public:
+  /**
+  * \param out destination of the text records
+  * \param box_name name of the shared ring
+  * \throw std::runtime_error if the ring cannot be opened
+  */
+  SampleSink(std::ostream& out, const std::string& box_name, const RingOptions& ring_options);
+
+  /**
+  * Write and publish a decoded batch
+  * \param own_time true if the decoder stamps samples itself, otherwise the host time of arrival is used
+  */
+  void write(SampleBatch& batch, bool own_time);
+
+  void poll();
+  void flush();
+
+#if defined (USE_HOST_MEMORY)
+  const SharedChannel& channel() const;
+#endif
+
+  /**
+  * Print the latency statistics, nothing if no sample was written
+  */
+  void report(std::ostream& out) const;
+
+private:
+  RecordWriter writer;
+#if defined (USE_HOST_MEMORY)
+  SharedChannel shared;
+#endif
+  RecordSchema schema;
+  TimeFormatter time_format;
+  char record[RECORD_MAX_SIZE];
+  int64_t latency_sum;
+  int64_t latency_max;
+  size_t latency_count;
+};
+
+SampleSink::SampleSink(std::ostream& out, const std::string& box_name, const RingOptions& ring_options)
+  : writer(out),
+#if defined (USE_HOST_MEMORY)
+  shared(box_name, ring_options),
+#endif
+  schema(RecordSchema::defaults()), latency_sum(0), latency_max(0), latency_count(0) {}
+
+void SampleSink::write(SampleBatch& batch, bool own_time){
+  for (size_t i = 0; i < batch.size(); i++) {
+    NavData& navdata = batch[i];
+    if (!own_time || !navdata.isSet(POS_TIME)) navdata.setTimestamp(navdata.getArrival().realtime, 3);
+
+    writer.write(record, navdata.format(record, sizeof(record), schema, time_format));
+
+#if defined (USE_HOST_MEMORY)
+    shared.push(navdata.toRecord());
+#endif
+  }
+#if defined (USE_HOST_MEMORY)
+  shared.publish();
+#endif
+
+  if (batch.empty()) return;
+  int64_t latency = monotonic_nanoseconds() - batch.getArrival().monotonic;
+  latency_sum += latency * (int64_t)batch.size();
+  latency_count += batch.size();
+  latency_max = std::max(latency_max, latency);
+}
+
+void SampleSink::poll(){
+  writer.poll();
+}
+
+void SampleSink::flush(){
+  writer.flush();
+}
+
+#if defined (USE_HOST_MEMORY)
+const SharedChannel& SampleSink::channel() const {
+  return shared;
+}
+#endif
+
+void SampleSink::report(std::ostream& out) const {
+  if (latency_count) out << "Ingest latency: mean " << latency_sum / (int64_t)latency_count / 1000 << " us, max " << latency_max / 1000 << " us" << std::endl;
+}
+
+//***************************************************************************************************************
+
+/**
+* A box to acquire: serial port, baud rate and 1-based box type
+*/
+struct PortSpec {
+  std::string port;
+  unsigned int baudrate;
+  size_t box_type;
+};
+
+/**
+* Parse PORT:BAUDRATE:TYPE, as given to serial_reader -m
+* \param box_count number of known box types
+* \return false if the text is malformed or the box type unknown
+*/
+bool parse_port_spec(const std::string& text, size_t box_count, PortSpec& spec){
+  size_t type_sep = text.rfind(':');
+  if (type_sep == std::string::npos || type_sep == 0) return false;
+  size_t baud_sep = text.rfind(':', type_sep - 1);
+  if (baud_sep == std::string::npos || baud_sep == 0) return false;
+
+  int64_t baudrate, box_type;
+  if (parse_integer(text.data() + baud_sep + 1, text.data() + type_sep, baudrate) != numberOk || baudrate <= 0 || baudrate > UINT_MAX) return false;
+  if (parse_integer(text.data() + type_sep + 1, text.data() + text.size(), box_type) != numberOk || box_type < 1 || box_type > (int64_t)box_count) return false;
+  spec.port = text.substr(0, baud_sep);
+  spec.baudrate = (unsigned int)baudrate;
+  spec.box_type = (size_t)box_type;
+  return true;
+}
+
+/**
+* One box served by a shared io_context: a chain of asynchronous reads feeds
+* its own decoder, and the samples go to its own log file and ring.
+* Errors stop this port only, the others keep going.
+*/
+class PortReader : private boost::noncopyable {
+public:
+  /**
+  * Open the port, the log file BOX.log and the ring of the box
+  * \param tuning low latency mode of the driver and read chunk size; device and baud rate come from spec
+  * \throw std::exception if any of them cannot be opened
+  */
+  PortReader(boost::asio::io_context& io, const PortSpec& spec, const RingOptions& ring_options, const SerialOptions& tuning);
+
+  /**
+  * Start reading; the data is handled by the threads running the io_context
+  */
+  void start();
+
+  /**
+  * Cancel the reads and close the port
+  */
+  void close();
+
+  /**
+  * \return false once the port has failed or has been closed
+  */
+  bool isOpen() const;
+
+  void poll();
+  void flush();
+
+  const std::string& boxName() const;
+  const PortSpec& spec() const;
+  const FrameDecoder& frameDecoder() const;
+  const SampleSink& sink() const;
+
+private:
+  void doRead();
+  void readEnd(const boost::system::error_code& error, size_t bytes_transferred);
+
+  PortSpec port_spec;
+  std::string box_name;
+  boost::asio::serial_port port;
+  boost::shared_ptr<FrameDecoder> decoder;
+  std::ofstream logfile;
+  SampleSink samples;
+  std::vector<char> buffer;
+  SampleBatch batch;
+  bool open;
+};
+
+PortReader::PortReader(boost::asio::io_context& io, const PortSpec& spec, const RingOptions& ring_options, const SerialOptions& tuning)
+  : port_spec(spec), box_name(get_box_types()[spec.box_type - 1]), port(io, spec.port), decoder(make_decoder(spec.box_type)),
+  logfile(box_name + ".log", std::ofstream::out), samples(logfile, box_name, ring_options), buffer(tuning.getReadChunkSize()), open(true) {
+  if (!logfile.is_open()) throw std::runtime_error("cannot open " + box_name + ".log");
+  port.set_option(boost::asio::serial_port_base::baud_rate(spec.baudrate));
+  port.set_option(boost::asio::serial_port_base::parity(boost::asio::serial_port_base::parity::none));
+  port.set_option(boost::asio::serial_port_base::character_size(8));
+  port.set_option(boost::asio::serial_port_base::flow_control(boost::asio::serial_port_base::flow_control::none));
+  port.set_option(boost::asio::serial_port_base::stop_bits(boost::asio::serial_port_base::stop_bits::one));
+
+  SerialOptions options(tuning);
+  options.setDevice(spec.port);
+  options.setBaudrate(spec.baudrate);
+  tune_serial_port(port.native_handle(), options);
+}
+
+void PortReader::start(){
+  doRead();
+}
+
+void PortReader::close(){
+  if (!open) return;
+  open = false;
+  boost::system::error_code ignored;
+  port.cancel(ignored);
+  port.close(ignored);
+}
+
+bool PortReader::isOpen() const {
+  return open;
+}
+
+void PortReader::poll(){
+  samples.poll();
+}
+
+void PortReader::flush(){
+  samples.flush();
+}
+
+const std::string& PortReader::boxName() const {
+  return box_name;
+}
+
+const PortSpec& PortReader::spec() const {
+  return port_spec;
+}
+
+const FrameDecoder& PortReader::frameDecoder() const {
+  return *decoder;
+}
+
+const SampleSink& PortReader::sink() const {
+  return samples;
+}
+
+void PortReader::doRead(){
+  port.async_read_some(boost::asio::buffer(buffer.data(), buffer.size()),
+    boost::bind(&PortReader::readEnd, this, boost::asio::placeholders::error, boost::asio::placeholders::bytes_transferred));
+}
+
+void PortReader::readEnd(const boost::system::error_code& error, size_t bytes_transferred){
+  if (error) {
+    if (open) std::cout << "Error: " << box_name << " on " << port_spec.port << ": " << error.message() << std::endl;
+    close();
+    return;
+  }
+
+  batch.clear();
+  batch.setArrival(ArrivalStamp::now());
+  decoder->feed(buffer.data(), bytes_transferred, batch);
+  samples.write(batch, decoder->hasOwnTime());
+  doRead();
+}
@@ -0,0 +1,290 @@
+// Copyright 2014, 2015 Stefano Sinigardi, Alessandro Fabbri
+// for any question, please mail stefano.sinigardi@gmail.com
+
+#pragma once
+
+#include "datalogger.h"
+#include "port_reader.hpp"
+#include "sample_ring.h"
+#include <atomic>
+#include <boost/lockfree/spsc_queue.hpp>
+
+#define PIPELINE_DEPTH 256    // chunks, and batches, in flight between two stages
+#define PIPELINE_WAIT_MS 100  // longest sleep of an idle stage, so that the sink can still flush the writer by age
+
+
+/**
+* Bytes as they came from the port, handed from the reader to the decode stage
+*/
+struct ByteChunk {
+  std::vector<char> data;
+  size_t size;
+  ArrivalStamp arrival;
+  ByteChunk();
+};
+
+ByteChunk::ByteChunk() : data(READ_CHUNK_SIZE), size(0) {}
+
+/**
+* Lets an idle stage sleep until the stage before it has pushed something.
+* As in SampleRingBase::wait(), the producer pays a system call only when the
+* consumer is actually sleeping: on Linux the consumer blocks on a futex,
+* elsewhere on a condition variable whose mutex the producer takes only then.
+*/
+class StageSignal : private boost::noncopyable {
+public:
+  StageSignal();
+
+  /**
+  * Producer: wake the consumer if it sleeps, after pushing
+  */
+  void notify();
+
+  /**
+  * Consumer: sleep until ready() holds, notify() is called or timeout_ms have passed
+  */
+  template <typename Ready> void wait(Ready ready, unsigned int timeout_ms);
+
+private:
+  std::atomic<uint32_t> word;
+  std::atomic<uint32_t> waiters;
+#if !defined(__linux__)
+  boost::mutex mutex;
+  boost::condition_variable condition;
+#endif
+};
+
+StageSignal::StageSignal() : word(0), waiters(0) {}
+
+void StageSignal::notify(){
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (!waiters.load(std::memory_order_relaxed)) return;
+#if defined(__linux__)
+  word.fetch_add(1, std::memory_order_release);
+  futex_wake_all(word);
+#else
+  {
+    boost::lock_guard<boost::mutex> lock(mutex);
+    word.fetch_add(1, std::memory_order_release);
+  }
+  condition.notify_all();
+#endif
+}
+
+template <typename Ready>
+void StageSignal::wait(Ready ready, unsigned int timeout_ms){
+#if !defined(__linux__)
+  boost::unique_lock<boost::mutex> lock(mutex);
+#endif
+  waiters.fetch_add(1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  uint32_t seen = word.load(std::memory_order_acquire);
+  if (!ready()) {
+#if defined(__linux__)
+    // returns at once if a notify() changed the word since it was read
+    futex_wait(word, seen, std::chrono::milliseconds(timeout_ms));
+#else
+    condition.timed_wait(lock, boost::posix_time::milliseconds(timeout_ms), [&]() { return word.load(std::memory_order_acquire) != seen; });
+#endif
+  }
+  waiters.fetch_sub(1, std::memory_order_relaxed);
+}
+
+/**
+* Queue length seen by a stage each time it takes an item
+*/
+class StageOccupancy {
+public:
+  StageOccupancy();
+  void sample(size_t length);
+  double mean() const;
+  size_t max() const;
+
+private:
+  uint64_t sum;
+  uint64_t count;
+  size_t peak;
+};
+
+StageOccupancy::StageOccupancy() : sum(0), count(0), peak(0) {}
+
+void StageOccupancy::sample(size_t length){
+  sum += length;
+  count++;
+  peak = std::max(peak, length);
+}
+
+double StageOccupancy::mean() const {
+  return count ? (double)sum / (double)count : 0.;
+}
+
+size_t StageOccupancy::max() const {
+  return peak;
+}
+
+/**
+* Splits the acquisition of a box in three stages, so that a slow disk never
+* delays the serial port: the thread reading the port only copies the bytes
+* into chunks, a decode thread turns chunks into sample batches and a sink
+* thread formats and writes them. The stages are connected by bounded lock-free
+* single producer single consumer queues, and every chunk and batch is
+* preallocated and recycled through a queue going back, so nothing is
+* allocated once running. If the decode stage falls behind by a whole queue
+* the reader drops the bytes instead of waiting, and counts them. Idle stages
+* sleep on a StageSignal, woken by the stage before them.
+*/
+class ReaderPipeline : private boost::noncopyable {
+public:
+  /**
+  * Start the decode and sink threads
+  * \param decoder decoder of the box, used by the decode thread only from now on
+  * \param sink destination of the batches, used by the sink thread only from now on
+  * \param depth number of chunks and of batches in flight
+  */
+  ReaderPipeline(FrameDecoder& decoder, SampleSink& sink, size_t depth = PIPELINE_DEPTH);
+  ~ReaderPipeline();
+
+  /**
+  * Hand the bytes just read to the decode stage, never waiting; to be called by one thread
+  * \return false if some bytes were dropped because the decode stage is full
+  */
+  bool push(const char* data, size_t len);
+
+  /**
+  * Decode and write everything pushed so far, then stop the threads.
+  * The reader must not push anymore.
+  */
+  void stop();
+
+  uint64_t chunksRead() const;
+  uint64_t bytesDropped() const;
+
+  /**
+  * Print the occupancy of the queues feeding the decode and the sink stages
+  */
+  void report(std::ostream& out) const;
+
+private:
+  void decodeLoop();
+  void sinkLoop();
+
+  FrameDecoder& decoder;
+  SampleSink& sink;
+  bool own_time;
+  size_t depth;
+  std::vector<ByteChunk> chunks;
+  std::vector<SampleBatch> batches;
+  boost::lockfree::spsc_queue<ByteChunk*> full_chunks, free_chunks;
+  boost::lockfree::spsc_queue<SampleBatch*> full_batches, free_batches;
+  std::atomic<bool> reading, decoding;
+  StageSignal chunks_ready, batches_ready, batches_free;
+  uint64_t chunks_read;
+  std::atomic<uint64_t> bytes_dropped;
+  StageOccupancy decode_occupancy, sink_occupancy;
+  boost::thread_group stages;
+};
+
+ReaderPipeline::ReaderPipeline(FrameDecoder& decoder, SampleSink& sink, size_t depth)
+  : decoder(decoder), sink(sink), own_time(decoder.hasOwnTime()), depth(depth), chunks(depth), batches(depth),
+  full_chunks(depth), free_chunks(depth), full_batches(depth), free_batches(depth), reading(true), decoding(true),
+  chunks_read(0), bytes_dropped(0) {
+  for (size_t i = 0; i < depth; i++) {
+    free_chunks.push(&chunks[i]);
+    free_batches.push(&batches[i]);
+  }
+  stages.create_thread(boost::bind(&ReaderPipeline::decodeLoop, this));
+  stages.create_thread(boost::bind(&ReaderPipeline::sinkLoop, this));
+}
+
+ReaderPipeline::~ReaderPipeline(){
+  stop();
+}
+
+bool ReaderPipeline::push(const char* data, size_t len){
+  ArrivalStamp arrival = ArrivalStamp::now();
+  bool complete = true;
+  while (len) {
+    ByteChunk* chunk;
+    if (!free_chunks.pop(chunk)) {
+      bytes_dropped.fetch_add(len, std::memory_order_relaxed);
+      complete = false;
+      break;
+    }
+    chunk->size = std::min(len, chunk->data.size());
+    memcpy(chunk->data.data(), data, chunk->size);
+    chunk->arrival = arrival;
+    full_chunks.push(chunk);
+    chunks_read++;
+    data += chunk->size;
+    len -= chunk->size;
+  }
+  chunks_ready.notify();
+  return complete;
+}
+
+void ReaderPipeline::stop(){
+  reading.store(false);
+  chunks_ready.notify();
+  stages.join_all();
+}
+
+uint64_t ReaderPipeline::chunksRead() const {
+  return chunks_read;
+}
+
+uint64_t ReaderPipeline::bytesDropped() const {
+  return bytes_dropped.load(std::memory_order_relaxed);
+}
+
+void ReaderPipeline::report(std::ostream& out) const {
+  out << "Decode queue: mean " << std::fixed << std::setprecision(1) << decode_occupancy.mean() << ", max " << decode_occupancy.max() << " of " << depth << " chunks" << std::endl;
+  out << "Sink queue: mean " << sink_occupancy.mean() << ", max " << sink_occupancy.max() << " of " << depth << " batches" << std::endl;
+  out.unsetf(std::ios::floatfield);
+  if (bytesDropped()) out << "Dropped " << bytesDropped() << " bytes, the decode stage was full" << std::endl;
+}
+
+void ReaderPipeline::decodeLoop(){
+  SampleBatch* batch = 0;
+  for (;;) {
+    // read before looking at the queue: once the reader is done, an empty queue stays empty
+    bool more = reading.load();
+    ByteChunk* chunk;
+    if (!full_chunks.pop(chunk)) {
+      if (!more) break;
+      chunks_ready.wait([this]() { return full_chunks.read_available() > 0 || !reading.load(); }, PIPELINE_WAIT_MS);
+      continue;
+    }
+    decode_occupancy.sample(full_chunks.read_available() + 1);
+
+    // kept while the chunks decode to nothing, so that only this thread gives batches back
+    while (!batch && !free_batches.pop(batch)) batches_free.wait([this]() { return free_batches.read_available() > 0; }, PIPELINE_WAIT_MS);
+    batch->clear();
+    batch->setArrival(chunk->arrival);
+    decoder.feed(chunk->data.data(), chunk->size, *batch);
+    free_chunks.push(chunk);
+
+    if (batch->empty()) continue;
+    full_batches.push(batch);
+    batches_ready.notify();
+    batch = 0;
+  }
+  decoding.store(false);
+  batches_ready.notify();
+}
+
+void ReaderPipeline::sinkLoop(){
+  for (;;) {
+    bool more = decoding.load();
+    SampleBatch* batch;
+    if (!full_batches.pop(batch)) {
+      if (!more) break;
+      sink.poll();
+      batches_ready.wait([this]() { return full_batches.read_available() > 0 || !decoding.load(); }, PIPELINE_WAIT_MS);
+      continue;
+    }
+    sink_occupancy.sample(full_batches.read_available() + 1);
+    sink.write(*batch, own_time);
+    free_batches.push(batch);
+    batches_free.notify();
+  }
+}
@@ -0,0 +1,214 @@
+// Copyright 2014, 2015 Stefano Sinigardi, Alessandro Fabbri
+// for any question, please mail stefano.sinigardi@gmail.com
+
+#include "sample_ring.h"
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <new>
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+// not FUTEX_PRIVATE: producer and consumers usually live in different processes
+void futex_wait(std::atomic<uint32_t>& word, uint32_t expected, std::chrono::nanoseconds timeout){
+  struct timespec ts;
+  ts.tv_sec = (time_t)(timeout.count() / 1000000000);
+  ts.tv_nsec = (long)(timeout.count() % 1000000000);
+  syscall(SYS_futex, reinterpret_cast<uint32_t *>(&word), FUTEX_WAIT, expected, &ts, NULL, 0);
+}
+
+void futex_wake_all(std::atomic<uint32_t>& word){
+  syscall(SYS_futex, reinterpret_cast<uint32_t *>(&word), FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+}
+#endif
+
+RingOptions::RingOptions(uint64_t capacity, double sample_rate, bool huge_pages, bool compact)
+  : capacity(capacity), sample_rate(sample_rate), huge_pages(huge_pages), compact(compact) {}
+
+RingOptions RingOptions::window(double seconds, double sample_rate, bool huge_pages, bool compact){
+  return RingOptions((uint64_t)std::max(1., std::ceil(seconds * sample_rate)), sample_rate, huge_pages, compact);
+}
+
+size_t RingOptions::segmentSize() const {
+  size_t bytes = compact ? CompactSampleRing::bytes(capacity) : SampleRing::bytes(capacity);
+  if (huge_pages) bytes = (bytes + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+  return bytes;
+}
+
+
+static SampleRingHeader *ready_header(void *memory){
+  SampleRingHeader *header = static_cast<SampleRingHeader *>(memory);
+
+  // a segment just created by another process is zero filled until its creator is done
+  for (int waited = 0; header->magic.load(std::memory_order_acquire) != SAMPLE_RING_MAGIC; waited++) {
+    if (waited == SAMPLE_RING_ATTACH_MS) throw std::runtime_error("shared memory does not hold a sample ring");
+    boost::this_thread::sleep(boost::posix_time::milliseconds(1));
+  }
+  if (header->version != SAMPLE_RING_VERSION)
+    throw std::runtime_error("sample ring created by an incompatible version (" + std::to_string(header->version) + ")");
+  return header;
+}
+
+uint32_t sample_ring_layout(void *memory){
+  return ready_header(memory)->record_layout;
+}
+
+
+SampleRingBase::SampleRingBase() : header(NULL), next(0) {}
+
+SampleRingBase::SampleRingBase(SampleRingHeader *header) : header(header), next(header->head.load(std::memory_order_acquire)) {}
+
+bool SampleRingBase::valid() const {
+  return header != NULL;
+}
+
+uint64_t SampleRingBase::capacity() const {
+  return header->capacity;
+}
+
+double SampleRingBase::sampleRate() const {
+  return header->sample_rate;
+}
+
+std::string SampleRingBase::boxName() const {
+  return std::string(header->box_name);
+}
+
+uint64_t SampleRingBase::head() const {
+  return header->head.load(std::memory_order_acquire);
+}
+
+uint64_t SampleRingBase::publish(){
+  header->head.store(next, std::memory_order_release);
+
+  // pairs with the fence in wait(): either the waiter sees the new head or we see the waiter
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (header->waiters.load(std::memory_order_relaxed)) {
+    header->notify.fetch_add(1, std::memory_order_release);
+#if defined(__linux__)
+    futex_wake_all(header->notify);
+#endif
+  }
+  return next;
+}
+
+bool SampleRingBase::wait(uint64_t seen, unsigned int timeout_ms) const {
+  if (head() > seen) return true;
+
+  std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+  header->waiters.fetch_add(1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  while (true) {
+    uint32_t word = header->notify.load(std::memory_order_acquire);
+    if (head() > seen) break;
+    std::chrono::nanoseconds left = deadline - std::chrono::steady_clock::now();
+    if (left.count() <= 0) break;
+#if defined(__linux__)
+    // returns at once if a publish() changed the word since it was read
+    futex_wait(header->notify, word, left);
+#else
+    (void)word;
+    std::chrono::nanoseconds poll = std::chrono::milliseconds(SAMPLE_RING_POLL_MS);
+    boost::this_thread::sleep(boost::posix_time::microseconds(std::min(left, poll).count() / 1000));
+#endif
+  }
+  header->waiters.fetch_sub(1, std::memory_order_relaxed);
+  return head() > seen;
+}
+
+
+template <typename R>
+size_t BasicSampleRing<R>::bytes(uint64_t capacity){
+  return sizeof(SampleRingHeader) + (size_t)capacity * sizeof(Slot);
+}
+
+template <typename R>
+BasicSampleRing<R> BasicSampleRing<R>::create(void *memory, uint64_t capacity, double sample_rate, const char *box_name){
+  SampleRingHeader *header = new (memory) SampleRingHeader;
+  header->magic.store(0, std::memory_order_relaxed);
+  header->version = SAMPLE_RING_VERSION;
+  header->record_size = sizeof(Slot);
+  header->record_layout = R::LAYOUT;
+  header->capacity = capacity;
+  header->sample_rate = sample_rate;
+  memset(header->box_name, 0, sizeof(header->box_name));
+  strncpy(header->box_name, box_name, sizeof(header->box_name) - 1);
+  Slot *slots = reinterpret_cast<Slot *>(header + 1);
+  for (uint64_t i = 0; i < capacity; i++) {
+    new (&slots[i].sequence) std::atomic<typename R::Sequence>(0);
+    slots[i].data = R();
+  }
+  header->head.store(0, std::memory_order_relaxed);
+  new (&header->notify) std::atomic<uint32_t>(0);
+  new (&header->waiters) std::atomic<uint32_t>(0);
+  header->magic.store(SAMPLE_RING_MAGIC, std::memory_order_release);
+  return BasicSampleRing(header);
+}
+
+template <typename R>
+BasicSampleRing<R> BasicSampleRing<R>::attach(void *memory, size_t bytes){
+  SampleRingHeader *header = ready_header(memory);
+  if (header->record_layout != R::LAYOUT || header->record_size != sizeof(Slot))
+    throw std::runtime_error("sample ring holds records of another layout (" + std::to_string(header->record_layout) + ")");
+  if (bytes && bytes < BasicSampleRing::bytes(header->capacity))
+    throw std::runtime_error("sample ring larger than its shared memory segment");
+
+  return BasicSampleRing(header);
+}
+
+template <typename R>
+BasicSampleRing<R>::BasicSampleRing() : slots(NULL) {}
+
+template <typename R>
+BasicSampleRing<R>::BasicSampleRing(SampleRingHeader *header) : SampleRingBase(header), slots(reinterpret_cast<Slot *>(header + 1)) {}
+
+template <typename R>
+void BasicSampleRing<R>::push(const R& record){
+  typedef typename R::Sequence Sequence;
+  Slot& slot = slots[next % header->capacity];
+  slot.sequence.store((Sequence)(2 * next + 1), std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  slot.data = record;
+  slot.sequence.store((Sequence)(2 * next + 2), std::memory_order_release);
+  next++;
+}
+
+template <typename R>
+bool BasicSampleRing<R>::read(uint64_t index, R& record) const {
+  typedef typename R::Sequence Sequence;
+  if (index >= head()) return false;
+  const Slot& slot = slots[index % header->capacity];
+  Sequence before = slot.sequence.load(std::memory_order_acquire);
+  if (before != (Sequence)(2 * index + 2)) return false;
+  record = slot.data;
+  std::atomic_thread_fence(std::memory_order_acquire);
+  return slot.sequence.load(std::memory_order_relaxed) == before;
+}
+
+template <typename R>
+size_t BasicSampleRing<R>::readLatest(R *records, size_t count, uint64_t& first) const {
+  uint64_t end = head();
+  uint64_t window = std::min<uint64_t>(count, header->capacity);
+  uint64_t begin = end > window ? end - window : 0;
+
+  // a failed read means the producer has lapped the reader up to there: the
+  // copies made before it are dropped so that the result stays contiguous
+  size_t copied = 0;
+  first = begin;
+  for (uint64_t i = begin; i < end; i++) {
+    if (read(i, records[copied])) copied++;
+    else {
+      copied = 0;
+      first = i + 1;
+    }
+  }
+  return copied;
+}
+
+template class BasicSampleRing<Record>;
+template class BasicSampleRing<CompactRecord>;
@@ -0,0 +1,216 @@
+// Copyright 2014, 2015 Stefano Sinigardi, Alessandro Fabbri
+// for any question, please mail stefano.sinigardi@gmail.com
+
+#pragma once
+
+#include "datalogger.h"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#define CACHE_LINE_SIZE         64
+#define HUGE_PAGE_SIZE          (2 << 20)
+#define SAMPLE_RING_MAGIC       0x474E5244    // "DRNG"
+#define SAMPLE_RING_VERSION     3
+#define SAMPLE_RING_NAME_SIZE   32
+#define SAMPLE_RING_ATTACH_MS   1000
+#define SAMPLE_RING_POLL_MS     1             // wait() granularity where the ring cannot block on a futex
+
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "the ring needs lock-free 64-bit atomics to be shared between processes");
+
+#if defined(__linux__)
+/**
+* Sleep while word holds expected, until a futex_wake_all() on it or the timeout.
+* The word may live in memory shared between processes.
+*/
+void futex_wait(std::atomic<uint32_t>& word, uint32_t expected, std::chrono::nanoseconds timeout);
+/**
+* Wake every thread sleeping in futex_wait() on word
+*/
+void futex_wake_all(std::atomic<uint32_t>& word);
+#endif
+
+/**
+* Start of the ring in memory. It describes the layout, so that a process can
+* attach to a segment without knowing how it was created. The head, written by
+* the producer, and the read-only description live in different cache lines so
+* that readers polling the head do not share a line with anything else.
+* Consumers blocked in SampleRingBase::wait() sleep on the notify word, which the
+* producer bumps only when waiters says someone is sleeping.
+*/
+struct SampleRingHeader {
+  alignas(CACHE_LINE_SIZE) std::atomic<uint32_t> magic; ///< SAMPLE_RING_MAGIC, stored last when the ring is ready
+  uint32_t version;                                     ///< SAMPLE_RING_VERSION of the creator
+  uint32_t record_size;                                 ///< sizeof(SampleSlot) of the creator
+  uint32_t record_layout;                               ///< RECORD_LAYOUT_FULL or RECORD_LAYOUT_COMPACT
+  uint64_t capacity;                                    ///< Number of slots
+  double sample_rate;                                   ///< Expected records per second, 0 if unknown
+  char box_name[SAMPLE_RING_NAME_SIZE];                 ///< Box type feeding the ring, null terminated
+  alignas(CACHE_LINE_SIZE) std::atomic<uint64_t> head;  ///< Records published since the ring was created
+  std::atomic<uint32_t> notify;                         ///< Futex word, changed by publish() to wake the waiters
+  std::atomic<uint32_t> waiters;                        ///< Consumers sleeping in wait()
+};
+
+/**
+* One record and its seqlock: the sequence is odd while the producer rewrites
+* the slot, and 2 * (index + 1), truncated to the sequence type, once record
+* number index is complete.
+*/
+template <typename R>
+struct SampleSlot {
+  std::atomic<typename R::Sequence> sequence;
+  R data;
+};
+
+static_assert(sizeof(SampleSlot<Record>) == CACHE_LINE_SIZE, "a slot should fill exactly one cache line");
+static_assert(sizeof(SampleSlot<CompactRecord>) == CACHE_LINE_SIZE / 2, "a compact slot should fill half a cache line");
+static_assert(sizeof(SampleRingHeader) == 2 * CACHE_LINE_SIZE, "description and head should take one cache line each");
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "the notify word is used as a futex");
+static_assert(POS_COUNT <= 16, "Record::valid has a bit for each field");
+
+/**
+* Size of a ring chosen at run time
+*/
+struct RingOptions {
+  /**
+  * \param capacity number of records
+  * \param sample_rate expected records per second, 0 if unknown
+  * \param huge_pages back the segment with huge pages where supported
+  * \param compact hold CompactRecord instead of Record
+  */
+  RingOptions(uint64_t capacity = DIMENSIONE_MAX, double sample_rate = 0., bool huge_pages = false, bool compact = false);
+
+  /**
+  * \return options for a ring holding seconds of records at sample_rate
+  */
+  static RingOptions window(double seconds, double sample_rate, bool huge_pages = false, bool compact = false);
+
+  /**
+  * \return bytes of the segment, rounded up to whole huge pages when they are used
+  */
+  size_t segmentSize() const;
+
+  uint64_t capacity;
+  double sample_rate;
+  bool huge_pages;
+  bool compact;
+};
+
+/**
+* Wait up to SAMPLE_RING_ATTACH_MS for the creator of the ring in memory to finish its initialization
+* \return RECORD_LAYOUT_FULL or RECORD_LAYOUT_COMPACT
+* \throw std::runtime_error if the memory does not hold a ring of this version
+*/
+uint32_t sample_ring_layout(void *memory);
+
+/**
+* Part of a ring that does not depend on the record type: its description,
+* the head and the wakeup of the consumers.
+*/
+class SampleRingBase {
+public:
+  SampleRingBase();
+
+  /**
+  * \return false for a default-constructed ring
+  */
+  bool valid() const;
+
+  uint64_t capacity() const;
+  double sampleRate() const;
+  std::string boxName() const;
+
+  /**
+  * \return number of records published so far; records head() - capacity() to head() - 1 are the readable ones
+  */
+  uint64_t head() const;
+
+  /**
+  * Producer: make every record pushed so far visible, waking the consumers in wait()
+  * \return new head
+  */
+  uint64_t publish();
+
+  /**
+  * Consumer: sleep until the head moves past seen
+  * \param seen head already processed by the caller
+  * \param timeout_ms longest time to sleep
+  * \return true if records past seen are published, false on timeout
+  */
+  bool wait(uint64_t seen, unsigned int timeout_ms) const;
+
+protected:
+  SampleRingBase(SampleRingHeader *header);
+
+  SampleRingHeader *header;
+  uint64_t next;  ///< Producer only: index of the next record pushed
+};
+
+/**
+* Single producer, multiple consumer ring of records over a block of memory,
+* usually a shared memory segment. Nothing is locked: the producer never waits
+* for readers, and a reader that is lapped finds out from the slot sequence
+* and skips the record instead of returning a torn copy.
+* The producer writes records with push() and makes all of them visible at
+* once with publish(), a single release store of the head.
+* Consumers either poll head() or sleep in wait() until the next publish():
+* on Linux they block on a futex in the shared header, elsewhere wait() falls
+* back to polling every SAMPLE_RING_POLL_MS.
+* Instantiated for Record and CompactRecord.
+*/
+template <typename R>
+class BasicSampleRing : public SampleRingBase {
+public:
+  typedef SampleSlot<R> Slot;
+
+  /**
+  * \param capacity number of records
+  * \return bytes of memory needed by a ring of capacity records
+  */
+  static size_t bytes(uint64_t capacity);
+
+  /**
+  * Initialize an empty ring in memory, which must be at least bytes(capacity) long and 64-byte aligned
+  * \param box_name stored in the header, truncated to SAMPLE_RING_NAME_SIZE - 1 characters
+  */
+  static BasicSampleRing create(void *memory, uint64_t capacity, double sample_rate = 0., const char *box_name = "");
+
+  /**
+  * Use a ring initialized by create(), possibly in another process, waiting up to
+  * SAMPLE_RING_ATTACH_MS for its creator to finish the initialization.
+  * \param bytes size of the memory, checked against the capacity in the header; 0 to skip the check
+  * \throw std::runtime_error if the memory does not hold a ring of this version and record layout
+  */
+  static BasicSampleRing attach(void *memory, size_t bytes = 0);
+
+  BasicSampleRing();
+
+  /**
+  * Producer: write the next record, not yet visible to readers
+  */
+  void push(const R& record);
+
+  /**
+  * Consumer: copy record number index
+  * \return false if the record is not published yet or has been overwritten
+  */
+  bool read(uint64_t index, R& record) const;
+
+  /**
+  * Consumer: copy the last records published, oldest first
+  * \param records destination, room for count records
+  * \param count records wanted
+  * \param first set to the index of records[0]
+  * \return number of records copied; skipped records are the oldest ones
+  */
+  size_t readLatest(R *records, size_t count, uint64_t& first) const;
+
+private:
+  BasicSampleRing(SampleRingHeader *header);
+
+  Slot *slots;
+};
+
+typedef BasicSampleRing<Record> SampleRing;
+typedef BasicSampleRing<CompactRecord> CompactSampleRing;
@@ -4,24 +4,105 @@
 #include "datalogger.h"
 #include "serial_tools.h"
 #include "swap_tools.hpp"
-#include "data_tools.hpp"
+#include "port_reader.hpp"
+#include "reader_pipeline.hpp"
 
 
+bool quit_requested()
+{
+  if (shutdown_requested()) return true;
+#ifdef _WIN32
+  return GetAsyncKeyState(VK_ESCAPE) != 0;
+#elif __APPLE__
+  return getc_unlocked(stdin) == 'q';
+#else
+  return fgetc_unlocked(stdin) == 'q';  // da implementare con fgetc_unlocked, questo e' solo un tentativo alla cieca, non so come funzioni!
+#endif
+}
+
+
+/**
+* Acquire all the boxes from one io_context until shutdown or until every port has failed
+* \return process exit code
+*/
+int run_ports(const std::vector<PortSpec>& specs, const RingOptions& ring_options, const SerialOptions& tuning)
+{
+  boost::asio::io_context io;
+  std::vector<boost::shared_ptr<PortReader> > readers;
+  try {
+    for (auto& spec : specs) {
+      std::cout << "Connecting to box TYPE " << get_box_types()[spec.box_type - 1] << " on PORT " << spec.port << " with BAUDRATE " << spec.baudrate << std::endl;
+      readers.push_back(boost::shared_ptr<PortReader>(new PortReader(io, spec, ring_options, tuning)));
+#if defined (USE_HOST_MEMORY)
+      const SharedChannel& channel = readers.back()->sink().channel();
+      std::cout << "Shared ring " << channel.name() << ": " << channel.capacity() << (channel.isCompact() ? " compact" : "") << " records" << std::endl;
+#endif
+    }
+  }
+  catch (std::exception& e) {
+    std::cout << "Error: " << e.what() << std::endl;
+    return 1;
+  }
+
+  // flushes the writers of quiet ports and notices the shutdown request
+  boost::asio::deadline_timer timer(io);
+  std::function<void(const boost::system::error_code&)> tick = [&](const boost::system::error_code&) {
+    bool running = false;
+    for (auto& reader : readers) {
+      reader->poll();
+      running = running || reader->isOpen();
+    }
+    if (shutdown_requested() || !running) {
+      for (auto& reader : readers) reader->close();
+      return;
+    }
+    timer.expires_from_now(boost::posix_time::milliseconds(PORT_POLL_MS));
+    timer.async_wait(tick);
+  };
+
+  for (auto& reader : readers) reader->start();
+  timer.expires_from_now(boost::posix_time::milliseconds(PORT_POLL_MS));
+  timer.async_wait(tick);
+  io.run();
+
+  for (auto& reader : readers) {
+    reader->flush();
+    const FrameDecoder& decoder = reader->frameDecoder();
+    std::cout << reader->boxName() << " frames decoded: " << decoder.framesAccepted() << ", rejected: " << decoder.framesRejected() << ", dropped: " << decoder.framesDropped() << ", ignored: " << decoder.framesIgnored() << std::endl;
+    reader->sink().report(std::cout);
+  }
+  return 0;
+}
+
 
 int main(int argc, char ** argv)
 {
   size_t systeminfo = 0;
   std::cout << "Datalogger v" << MAJOR_VERSION << "." << MINOR_VERSION << std::endl;
-  std::cout << "Usage: " << argv[0] << " -p [serial_port] -b [baudrate] -t [box_type] -h (shows help and quit)" << std::endl;
+  std::cout << "Usage: " << argv[0] << " -p [serial_port] -b [baudrate] -t [box_type] -n [records] -w [seconds] -r [rate] -l -c -u -s -m [port:baudrate:box_type] -h (shows help and quit)" << std::endl;
   std::cout << "\t- [serial_port] serial port name (COMx on WIN, /dev/ttyUSBx on UNIX)" << std::endl;
   std::cout << "\t- [baudrate] " << std::endl;
   std::cout << "\t- [box_type] " << std::endl;
+  std::cout << "\t- [records] shared memory ring size, if the ring does not exist yet" << std::endl;
+  std::cout << "\t- [seconds] [rate] ring size as a time window at the given samples per second" << std::endl;
+  std::cout << "\t- -l back the ring with huge pages" << std::endl;
+  std::cout << "\t- -c share only the inertial values, in compact records" << std::endl;
+  std::cout << "\t- -u put the serial driver in low latency mode (ASYNC_LOW_LATENCY, Linux only), so that USB adapters" << std::endl;
+  std::cout << "\t  hand over bytes as they arrive; it is the only driver setting tuned, the kernel receive buffer is left as it is" << std::endl;
+  std::cout << "\t- -s read, decode and write in three threads, so that the serial port never waits for the disk" << std::endl;
+  std::cout << "\t- [port:baudrate:box_type] acquire this box too, repeat -m for each box; all of them are served by" << std::endl;
+  std::cout << "\t  this process and each one is logged to its own BOX.log, -p -b -t are ignored" << std::endl;
   std::cout << "new: general fixes and improvements\n" << std::endl;
 
   std::string serial_port = "";
   int baudrate = -1;
   bool serial_port_found = false;
   bool baudrate_found = false;
+  RingOptions ring_options;
+  double ring_seconds = 0.;
+  bool low_latency = false;
+  bool pipelined = false;
+  std::vector<std::string> port_specs;
 
   if (argc > 1) { /* Parse arguments, if there are arguments supplied */
     for (int i = 1; i < argc; i++) {
@@ -36,6 +117,30 @@ int main(int argc, char ** argv)
         case 't':
           systeminfo = atoi(argv[++i]);
           break;
+        case 'n':
+          ring_options.capacity = strtoull(argv[++i], NULL, 10);
+          break;
+        case 'w':
+          ring_seconds = atof(argv[++i]);
+          break;
+        case 'r':
+          ring_options.sample_rate = atof(argv[++i]);
+          break;
+        case 'l':
+          ring_options.huge_pages = true;
+          break;
+        case 'c':
+          ring_options.compact = true;
+          break;
+        case 'u':
+          low_latency = true;
+          break;
+        case 's':
+          pipelined = true;
+          break;
+        case 'm':
+          port_specs.push_back(argv[++i]);
+          break;
         case 'h':
           exit(777);
         default:    // no match...
@@ -51,7 +156,31 @@ int main(int argc, char ** argv)
   }
   else { std::cout << "Using default parameters" << std::endl; }
 
-  std::vector<std::string> box_types({ "Infomobility", "MagnetiMarelli", "Texa", "ViaSat", "MetaSystem", "UBX", "Octo", "NMEA", "MagnetiMarelli_v2", "MetaSystem_v2" });
+  std::vector<std::string> box_types = get_box_types();
+  if (ring_seconds > 0. && ring_options.sample_rate > 0.) ring_options = RingOptions::window(ring_seconds, ring_options.sample_rate, ring_options.huge_pages, ring_options.compact);
+
+  if (!port_specs.empty()) {
+    std::vector<PortSpec> specs;
+    std::vector<bool> box_used(box_types.size(), false);
+    for (auto& text : port_specs) {
+      PortSpec spec;
+      if (!parse_port_spec(text, box_types.size(), spec)) {
+        std::cout << "Error: " << text << " is not port:baudrate:box_type" << std::endl;
+        return 1;
+      }
+      // the ring of a box has a single producer
+      if (box_used[spec.box_type - 1]) {
+        std::cout << "Error: box type " << box_types[spec.box_type - 1] << " given twice" << std::endl;
+        return 1;
+      }
+      box_used[spec.box_type - 1] = true;
+      specs.push_back(spec);
+    }
+    SerialOptions tuning;
+    tuning.setLowLatency(low_latency);
+    install_shutdown_handler();
+    return run_ports(specs, ring_options, tuning);
+  }
 
   while (systeminfo < 1 || systeminfo > box_types.size()) {
     std::cout << "Which kind of system is attached? Answer with the number" << std::endl;
@@ -109,14 +238,12 @@ int main(int argc, char ** argv)
     }
   }
 
+  install_shutdown_handler();
+
   std::cout << "Connecting to box TYPE " << box_types[systeminfo - 1] << " on PORT " << serial_port << " with BAUDRATE " << baudrate << std::endl;
 
-  NavData navdata;
-  int indiceData = 0;
-  size_t counter = 0;
   bool exit = false;
   std::ofstream logfile;
-  time_t tnow;
 
 
   SerialOptions portacom;
@@ -127,6 +254,7 @@ int main(int argc, char ** argv)
   portacom.setParity(SerialOptions::noparity);
   portacom.setCsize(8);
   portacom.setStopBits(SerialOptions::one);
+  portacom.setLowLatency(low_latency);
 
 #ifndef WRITE_ON_STDOUT
   logfile.open(box_types[systeminfo - 1] + ".log", std::ofstream::out);
@@ -137,722 +265,115 @@ int main(int argc, char ** argv)
   //auto coutbuf = std::cout.rdbuf(logfile.rdbuf());
 #endif
 
-#if defined (USE_HOST_MEMORY)
-  Data *data;
-  data = (Data*)get_host_allocated_memory(box_types[systeminfo - 1].c_str());
-#endif
-
-  InfomobilityData idato;
-  MetasystemData mdato;
-  GPSData gdato;
-  OctoData odato;
-  std::vector<boost::regex> patterns;
-  //std::vector<std::string> pattern_names({ "GSV", "GLL", "RMC", "VTG", "GGA", "GSA" });
-  std::vector<std::string> pattern_names({ "RMC" });
-  bool extracted_data;
-
-  switch (systeminfo) {
-  case 1: //Infomobility
-  {
-    TimeoutSerial serial(portacom.getDevice(), portacom.getBaudrate());
-    serial.setTimeout(boost::posix_time::seconds(0));
-
-    try {
-
-      while (exit == false)
-      {
-#ifdef _WIN32
-        if (GetAsyncKeyState(VK_ESCAPE))
-#elif __APPLE__
-        if (getc_unlocked(stdin) == 'q')   
-#else
-        if (fgetc_unlocked(stdin) == 'q')  // da implementare con fgetc_unlocked, questo e' solo un tentativo alla cieca, non so come funzioni!
-#endif
-        {
-          exit = true;
-        }
-
-        idato.loadheaderS(serial);
-        idato.allocatePayload(idato.getPayloadSize());
-        idato.readPayloadS(serial);
-        idato.loadfooterS(serial);
-        idato.checkfooter();
-        //idato.printheader();
-        //idato.printfooter();
-        idato.saveheader(logfile);
-        idato.savefooter(logfile);
-        //idato.deAllocatePayload();
-        if (idato.isGPSData())
-        {
-          idato.recordGPSDataFromPayload();
-#ifdef WRITE_ON_STDOUT
-          idato.printGPSData();
-#else 
-          idato.saveGPSData(logfile);
-#endif
-        }
-        else
-        {
-          idato.recordACCDataFromPayload();
-#ifdef WRITE_ON_STDOUT
-          idato.printACCData();
-#else
-          idato.saveACCData(logfile);
-#endif
-        }
-
-#ifdef ENABLE_SLEEP
-        boost::this_thread::sleep(boost::posix_time::microseconds((int64_t)(SLEEP_TIME_MICROSECONDS)));
-#endif
-      }
-    }
-
-    catch (boost::system::system_error& e) {
-      std::cout << "Error: " << e.what() << std::endl;
-      return 1;
-    }
-    break;
-  }
-  case 2: //MagnetiMarelli
-  {
-    SerialStream sserial(portacom);
-    sserial.exceptions(std::ios::badbit | std::ios::failbit);
-
-    try {
-      std::string sst;
-      std::vector<std::string> strs;
-
-      while (exit == false) {
-#ifdef _WIN32
-        if (GetAsyncKeyState(VK_ESCAPE))
-#elif __APPLE__
-        if (getc_unlocked(stdin) == 'q')   
-#else
-        if (fgetc_unlocked(stdin) == 'q')  // da implementare con fgetc_unlocked, questo e' solo un tentativo alla cieca, non so come funzioni!
-#endif
-        {
-          exit = true;
-        }
-
-        try {
-          std::getline(sserial, sst);
-        }
-        catch (TimeoutException&) {
-          sserial.clear(); //Don't forget to clear error flags after a timeout
-          std::cerr << "Timeout occurred" << std::endl;
-        }
-
-        tnow = time(NULL);
-
-        if (sst[0] == '{') {
-          boost::algorithm::split(strs, sst, boost::algorithm::is_any_of("{}; "));
-          navdata.setTime(tnow);
-          navdata.setAcc_s(&strs[0]);
-#ifdef WRITE_ON_STDOUT
-          std::cout << navdata.to_string() << std::endl;
-#else
-          logfile << navdata.to_string() << std::endl;
-#endif
-        }
-        else {
-          boost::algorithm::split(strs, sst, boost::algorithm::is_any_of("; "));
-          double gyr_data[3];
-          for (size_t i = 0; i < strs.size(); i++) gyr_data[i] = atof(strs[i].c_str()) / 256.;
-          navdata.setTime(tnow);
-          navdata.setGyr(gyr_data);
-#ifdef WRITE_ON_STDOUT
-          std::cout << navdata.to_string() << std::endl;
-#else
-          logfile << navdata.to_string() << std::endl;
-#endif
-        }
-        break;
-
-#if defined (USE_HOST_MEMORY)
-        if (navdata.getAcc_s()[2].size()) {
-          data[indiceData].d[0] = (double)counter++;
-          data[indiceData].set(navdata.getInertial());
-          indiceData = (indiceData + 1) % DIMENSIONE_MAX;
-        }
-#endif
-
-#ifdef ENABLE_SLEEP
-        boost::this_thread::sleep(boost::posix_time::microseconds((int64_t)(SLEEP_TIME_MICROSECONDS)));
-#endif
-      }
-    }
-    catch (boost::system::system_error& e)
-    {
-      std::cout << "Error: " << e.what() << std::endl;
-      return 1;
-    }
-    break;
+  boost::shared_ptr<FrameDecoder> decoder = make_decoder(systeminfo);
+  if (!decoder) {
+    std::cout << "Error: unidentified object #" << systeminfo << std::endl;
+    return 1;
   }
 
-  case 3: // Texa
-  {
-    SerialStream sserial(portacom);
-    sserial.exceptions(std::ios::badbit | std::ios::failbit);
-
-    try {
-      std::string sst;
-      std::vector<std::string> strs;
-
-      while (exit == false)
-      {
-#ifdef _WIN32
-        if (GetAsyncKeyState(VK_ESCAPE))
-#elif __APPLE__
-        if (getc_unlocked(stdin) == 'q')   
-#else
-        if (fgetc_unlocked(stdin) == 'q')  // da implementare con fgetc_unlocked, questo e' solo un tentativo alla cieca, non so come funzioni!
-#endif
-        {
-          exit = true;
-        }
-
-        try {
-          std::getline(sserial, sst);
-        }
-        catch (TimeoutException&) {
-          sserial.clear(); //Don't forget to clear error flags after a timeout
-          std::cerr << "Timeout occurred" << std::endl;
-        }
-
-        tnow = time(NULL);
-        boost::algorithm::split(strs, sst, boost::algorithm::is_any_of(";"));
-        if (strs.size() == 21 && strs[0] != "Index") {
-          navdata.setInertial_s(&strs[strs.size() - 9]);
-          navdata.setTime(tnow);
-        }
-
 #ifdef WRITE_ON_STDOUT
-        std::cout << navdata.to_string() << std::endl;
+  std::ostream& output = std::cout;
 #else
-        logfile << navdata.to_string() << std::endl;
-#endif
-
-#if defined (USE_HOST_MEMORY)
-        if (navdata.getAcc_s()[2].size()) {
-          data[indiceData].d[0] = (double)counter++;
-          data[indiceData].set(navdata.getInertial());
-          indiceData = (indiceData + 1) % DIMENSIONE_MAX;
-        }
+  std::ostream& output = logfile;
 #endif
-
-#ifdef ENABLE_SLEEP
-        boost::this_thread::sleep(boost::posix_time::microseconds((int64_t)(SLEEP_TIME_MICROSECONDS)));
-#endif
-      }
-    }
-    catch (boost::system::system_error& e)
-    {
-      std::cout << "Error: " << e.what() << std::endl;
-      return 1;
-    }
-    break;
+  boost::shared_ptr<SampleSink> sink;
+  try {
+    sink.reset(new SampleSink(output, box_types[systeminfo - 1], ring_options));
   }
-  case 4: // ViaSat
-  {
-    SerialStream sserial(portacom);
-    sserial.exceptions(std::ios::badbit | std::ios::failbit);
-
-    try {
-      std::string sst;
-      std::vector<std::string> strs;
-
-      while (exit == false)
-      {
-#ifdef _WIN32
-        if (GetAsyncKeyState(VK_ESCAPE))
-#elif __APPLE__
-        if (getc_unlocked(stdin) == 'q')   
-#else
-        if (fgetc_unlocked(stdin) == 'q')  // da implementare con fgetc_unlocked, questo e' solo un tentativo alla cieca, non so come funzioni!
-#endif
-        {
-          exit = true;
-        }
-
-        try {
-          std::getline(sserial, sst);
-        }
-        catch (TimeoutException&) {
-          sserial.clear(); //Don't forget to clear error flags after a timeout
-          std::cerr << "Timeout occurred" << std::endl;
-        }
-
-        tnow = time(NULL);
-
-        if (sst[1] == 'G')
-        {
-          boost::algorithm::split(strs, sst, boost::algorithm::is_any_of("{}; "));
-
-          navdata.setGyr_s(&strs[0]);
-          navdata.setTime(tnow);
-
-#ifdef WRITE_ON_STDOUT
-          std::cout << navdata.to_string() << std::endl;
-#else
-          logfile << navdata.to_string() << std::endl;
-#endif
-        }
-        else
-        {
-          sst.insert(8, " ", 1);
-          sst.insert(15, " ", 1);
-          boost::algorithm::split(strs, sst, boost::algorithm::is_any_of("$A* "));
-
-          double data_temp[3];
-          for (size_t i = 0; i < 3; i++) data_temp[i] = atof(strs[i].c_str()) / 1e3;
-          navdata.setAcc(data_temp);
-          navdata.setTime(tnow);
-
-#ifdef WRITE_ON_STDOUT
-          std::cout << navdata.to_string() << std::endl;
-#else
-          logfile << navdata.to_string() << std::endl;
-#endif
-        }
-
-#if defined (USE_HOST_MEMORY)
-        if (navdata.getAcc_s()[2].size()) {
-          data[indiceData].d[0] = (double)counter++;
-          data[indiceData].set(navdata.getInertial());
-          indiceData = (indiceData + 1) % DIMENSIONE_MAX;
-        }
-#endif
-
-#ifdef ENABLE_SLEEP
-        boost::this_thread::sleep(boost::posix_time::microseconds((int64_t)(SLEEP_TIME_MICROSECONDS)));
-#endif
-      }
-    }
-    catch (boost::system::system_error& e)
-    {
-      std::cout << "Error: " << e.what() << std::endl;
-      return 1;
-    }
-    break;
+  catch (std::exception& e) {
+    std::cout << "Error: " << e.what() << std::endl;
+    return 1;
   }
-
-  case 5: // MetaSystem
-  {
-    SerialStream sserial(portacom);
-    sserial.exceptions(std::ios::badbit | std::ios::failbit);
-
-    try {
-
-      while (exit == false)
-      {
-        std::string sst;
-        std::vector<std::string> strs;
-        raw raw_data[3];
-        std::vector<float> acc(3);
-
-#ifdef _WIN32
-        if (GetAsyncKeyState(VK_ESCAPE))
-#elif __APPLE__
-        if (getc_unlocked(stdin) == 'q')   
-#else
-        if (fgetc_unlocked(stdin) == 'q')  // da implementare con fgetc_unlocked, questo e' solo un tentativo alla cieca, non so come funzioni!
-#endif
-        {
-          exit = true;
-        }
-
-        try {
-          std::getline(sserial, sst, mdato.getAlignChar());
-        }
-        catch (TimeoutException&) {
-          sserial.clear(); //Don't forget to clear error flags after a timeout
-          std::cerr << "Timeout occurred" << std::endl;
-        }
-
-        tnow = time(NULL);
-
-
-        if (sst.size() == 6) {
-          raw_data[0].value_ch[0] = sst[0];
-          raw_data[0].value_ch[1] = sst[1];
-          raw_data[1].value_ch[0] = sst[2];
-          raw_data[1].value_ch[1] = sst[3];
-          raw_data[2].value_ch[0] = sst[4];
-          raw_data[2].value_ch[1] = sst[5];
-
-          raw_data[0].value_sh = (raw_data[0].value_ush << 1);
-          //if (raw_data[0].value_ch[1] & 0x4000) raw_data[0].value_ch[1] |= 0x8000; // PaoloPariani mod, not working
-          raw_data[1].value_sh = (raw_data[1].value_ush << 1);
-          raw_data[2].value_sh = (raw_data[2].value_ush << 1);
-
-          for (size_t i = 0; i < acc.size(); i++) acc[i] = ((float)raw_data[i].value_sh) / 1e3f;
-
-          navdata.setAcc(&acc[0]);
-          navdata.setTime(tnow);
-
-#ifdef WRITE_ON_STDOUT
-
-          std::cout << navdata.to_string() << std::endl;
-#else
-
-          logfile << navdata.to_string() << std::endl;
-#endif
-
 #if defined (USE_HOST_MEMORY)
-
-          if (navdata.getAcc_s()[2].size()) {
-            data[indiceData].d[0] = (double)counter++;
-            data[indiceData].set(navdata.getInertial());
-            indiceData = (indiceData + 1) % DIMENSIONE_MAX;
-          }
-#endif
-        }
-
-#ifdef ENABLE_SLEEP
-        boost::this_thread::sleep(boost::posix_time::microseconds((int64_t)(SLEEP_TIME_MICROSECONDS)));
-#endif
-      }
-    }
-
-    catch (boost::system::system_error& e)
-    {
-      std::cout << "Error: " << e.what() << std::endl;
-      return 1;
-    }
-    break;
-  }
-
-  case 6: // UBX
-  {
-    SerialStream sserial(portacom);
-    sserial.exceptions(std::ios::badbit | std::ios::failbit);
-
-    try {
+  const SharedChannel& channel = sink->channel();
+  std::cout << "Shared ring " << channel.name() << ": " << channel.capacity() << (channel.isCompact() ? " compact" : "") << " records" << std::endl;
+#endif
+
+  boost::shared_ptr<ReaderPipeline> pipeline;
+  if (pipelined) pipeline.reset(new ReaderPipeline(*decoder, *sink));
+
+  std::vector<char> buffer(READ_CHUNK_SIZE);
+  SampleBatch batch;
+
+  try {
+    if (box_types[systeminfo - 1] == "MetaSystem") {
+      // decoded directly in the serial thread, as bytes arrive; the writer is shared with
+      // this thread, which flushes it when the port goes quiet
+      boost::mutex writer_mutex;
+      CallbackAsyncSerial serial(serial_port, baudrate);
+      serial.tune(portacom);
+      serial.setCallback([&](const char *chunk, size_t len) {
+        if (pipeline) {
+          pipeline->push(chunk, len);
+          return;
+        }
+        batch.clear();
+        batch.setArrival(ArrivalStamp::now());
+        decoder->feed(chunk, len, batch);
+        boost::lock_guard<boost::mutex> lock(writer_mutex);
+        sink->write(batch, decoder->hasOwnTime());
+      });
 
       while (exit == false)
       {
-#ifdef _WIN32
-        if (GetAsyncKeyState(VK_ESCAPE))
-#elif __APPLE__
-        if (getc_unlocked(stdin) == 'q')   
-#else
-        if (fgetc_unlocked(stdin) == 'q')  // da implementare con fgetc_unlocked, questo e' solo un tentativo alla cieca, non so come funzioni!
-#endif
-        {
-          exit = true;
+        if (quit_requested()) exit = true;
+        if (serial.errorStatus() || !serial.isOpen()) throw std::runtime_error("serial port error");
+        if (!pipeline) {
+          boost::lock_guard<boost::mutex> lock(writer_mutex);
+          sink->poll();
         }
-
-        gdato.readDataStr(sserial);
-        navdata.setTime(gdato.gps_time, gdato.nano);
-
-#ifdef WRITE_ON_STDOUT
-        std::cout << navdata.to_string() << std::endl;
-#else
-        logfile << navdata.to_string() << std::endl;
-#endif
-
+        boost::this_thread::sleep(boost::posix_time::milliseconds(100));
       }
-    }
-    catch (boost::system::system_error& e)
-    {
-      std::cout << "Error: " << e.what() << std::endl;
-      return 1;
-    }
-    break;
-  }
-
-  case 7: // Octo
-  {
-    SerialStream sserial(portacom);
-    sserial.exceptions(std::ios::badbit | std::ios::failbit);
-
-    try {
 
-      while (exit == false)
-      {
-#ifdef _WIN32
-        if (GetAsyncKeyState(VK_ESCAPE))
-#elif __APPLE__
-        if (getc_unlocked(stdin) == 'q')   
-#else
-        if (fgetc_unlocked(stdin) == 'q')  // da implementare con fgetc_unlocked, questo e' solo un tentativo alla cieca, non so come funzioni!
-#endif
-        {
-          exit = true;
-        }
-        extracted_data = false;
-        odato.readDataStr(sserial, extracted_data);
-
-        if (extracted_data) {
-          tnow = time(NULL);
-
-          double data_temp[3];
-          switch (odato.type) {
-          case '1':
-            for (size_t i = 0; i < 3; i++) data_temp[i] = odato.acc_data[i] / 1e3;
-            navdata.setAcc(data_temp);
-            navdata.setTime(tnow);
-            break;
-          case '2':
-            for (size_t i = 0; i < 3; i++) data_temp[i] = odato.gyr_data[i] / 1e3;
-            navdata.setGyr(data_temp);
-            navdata.setTime(tnow);
-            break;
-          case '3':
-            // TODO
-          default:
-            break;
-          }
-
-#ifdef WRITE_ON_STDOUT
-          std::cout << navdata.to_string() << std::endl;
-#else
-          logfile << navdata.to_string() << std::endl;
-#endif
-
-
-#if defined (USE_HOST_MEMORY)
-          if (navdata.getAcc_s()[2].size()) {
-            data[indiceData].d[0] = (double)counter++;
-            data[indiceData].set(navdata.getInertial());
-            indiceData = (indiceData + 1) % DIMENSIONE_MAX;
-          }
-#endif
-
-          odato.data_v.clear();
-#ifdef ENABLE_SLEEP
-          boost::this_thread::sleep(boost::posix_time::microseconds((int64_t)(SLEEP_TIME_MICROSECONDS)));
-#endif
-        }
-      }
+      serial.clearCallback();
+      serial.close();
     }
-
-    catch (boost::system::system_error& e)
-    {
-      std::cout << "Error: " << e.what() << std::endl;
-      return 1;
-    }
-    break;
-  }
-
-  case 8: // NMEA
-  {
-    SerialStream sserial(portacom);
-    sserial.exceptions(std::ios::badbit | std::ios::failbit);
-
-    for (auto i : pattern_names) patterns.push_back(boost::regex(i));
-
-    try {
-      std::string sst;
-      std::vector<std::string> strs;
-      int nterm = 0;
-      int indiceData = 0;
-      bool exit = false;
-      bool found = false;
+    else {
+      SerialDevice serial(portacom);
 
       while (exit == false)
       {
-#ifdef _WIN32
-        if (GetAsyncKeyState(VK_ESCAPE))
-#elif __APPLE__
-        if (getc_unlocked(stdin) == 'q')   
-#else
-        if (fgetc_unlocked(stdin) == 'q')  // da implementare con fgetc_unlocked, questo e' solo un tentativo alla cieca, non so come funzioni!
-#endif
-        {
-          exit = true;
-        }
+        if (quit_requested()) exit = true;
 
+        std::streamsize nread;
         try {
-          std::getline(sserial, sst);
+          nread = serial.read(buffer.data(), buffer.size());
         }
         catch (TimeoutException&) {
-          sserial.clear(); //Don't forget to clear error flags after a timeout
           std::cerr << "Timeout occurred" << std::endl;
+          if (!pipeline) sink->poll();
+          continue;
         }
 
-        tnow = time(NULL);
-
-        boost::algorithm::split(strs, sst, boost::algorithm::is_any_of(","));
-        found = false;
-        for (auto i : patterns) if (boost::regex_search(strs[0], i)) found = true;
-
-        // TODO: save NMEA data into navdata
-
-#ifdef WRITE_ON_STDOUT
-        std::cout << navdata.to_string() << std::endl;
-#else
-        logfile << navdata.to_string() << std::endl;
-#endif
-      }
-    }
-    catch (boost::system::system_error& e)
-    {
-      std::cout << "Error: " << e.what() << std::endl;
-      return 1;
-    }
-    break;
-  }
-
-  case 9: // MagnetiMarelli_v2 //Octo-clone
-  {
-    SerialStream sserial(portacom);
-    sserial.exceptions(std::ios::badbit | std::ios::failbit);
-
-    try {
-
-      while (exit == false)
-      {
-#ifdef _WIN32
-        if (GetAsyncKeyState(VK_ESCAPE))
-#elif __APPLE__
-        if (getc_unlocked(stdin) == 'q')   
-#else
-        if (fgetc_unlocked(stdin) == 'q')  // da implementare con fgetc_unlocked, questo e' solo un tentativo alla cieca, non so come funzioni!
-#endif
-        {
-          exit = true;
+        if (pipeline) {
+          pipeline->push(buffer.data(), (size_t)nread);
+          continue;
         }
-        extracted_data = false;
-        odato.readDataStr(sserial, extracted_data);
-
-        if (extracted_data) {
-          tnow = time(NULL);
-
-          double data_temp[3];
-          switch (odato.type) {
-          case '1':
-            for (size_t i = 0; i < 3; i++) data_temp[i] = odato.acc_data[i] / 1e3;
-            navdata.setAcc(data_temp);
-            navdata.setTime(tnow);
-            break;
-          case '2':
-            for (size_t i = 0; i < 3; i++) data_temp[i] = odato.gyr_data[i] / 1e3;
-            navdata.setGyr(data_temp);
-            navdata.setTime(tnow);
-            break;
-          case '3':
-            // TODO
-          default:
-            break;
-          }
 
-#ifdef WRITE_ON_STDOUT
-          std::cout << navdata.to_string() << std::endl;
-#else
-          logfile << navdata.to_string() << std::endl;
-#endif
-
-
-#if defined (USE_HOST_MEMORY)
-          if (navdata.getAcc_s()[2].size()) {
-            data[indiceData].d[0] = (double)counter++;
-            data[indiceData].set(navdata.getInertial());
-            indiceData = (indiceData + 1) % DIMENSIONE_MAX;
-          }
-#endif
+        batch.clear();
+        batch.setArrival(ArrivalStamp::now());
+        decoder->feed(buffer.data(), (size_t)nread, batch);
+        sink->write(batch, decoder->hasOwnTime());
 
-          odato.data_v.clear();
 #ifdef ENABLE_SLEEP
-          boost::this_thread::sleep(boost::posix_time::microseconds((int64_t)(SLEEP_TIME_MICROSECONDS)));
+        boost::this_thread::sleep(boost::posix_time::microseconds((int64_t)(SLEEP_TIME_MICROSECONDS)));
 #endif
-        }
       }
     }
-
-    catch (boost::system::system_error& e)
-    {
-      std::cout << "Error: " << e.what() << std::endl;
-      return 1;
-    }
-    break;
   }
-
-
-  case 10: // MetaSystem_v2
+  catch (std::exception& e)
   {
-    SerialStream sserial(portacom);
-    sserial.exceptions(std::ios::badbit | std::ios::failbit);
-
-    float acc[3], gyro[3];
-
-    try {
-      std::string sst;
-      std::vector<std::string> strs;
-
-      while (exit == false)
-      {
-#ifdef _WIN32
-        if (GetAsyncKeyState(VK_ESCAPE))
-#elif __APPLE__
-        if (getc_unlocked(stdin) == 'q')   
-#else
-        if (fgetc_unlocked(stdin) == 'q')  // da implementare con fgetc_unlocked, questo e' solo un tentativo alla cieca, non so come funzioni!
-#endif
-        {
-          exit = true;
-        }
-
-        try {
-          std::getline(sserial, sst);
-        }
-        catch (TimeoutException&) {
-          sserial.clear(); //Don't forget to clear error flags after a timeout
-          std::cerr << "Timeout occurred" << std::endl;
-        }
-
-
-        //utcTime;nano;lat;lon;tV;fV;pdop;spd(mms);head;ax;ay;az;gx;gy;gz;cnt;rtctime
-
-        tnow = time(NULL);
-        boost::algorithm::split(strs, sst, boost::algorithm::is_any_of(";"));
-        //std::cout << sst << std::endl;
-        //std::cout << strs.size() << std::endl;
-        if ((BYPASS_CHECK && (strs.size() > 14)) || ((strs.size() == 18) && (strs[0] != "utcTime"))) {
-          acc[0] = (float)(atof(strs[9].c_str()) / 1000.);
-          acc[1] = (float)(atof(strs[10].c_str()) / 1000.);
-          acc[2] = (float)(atof(strs[11].c_str()) / 1000.);
-          gyro[0] = (float)(atof(strs[12].c_str()) / 60.);
-          gyro[1] = (float)(atof(strs[13].c_str()) / 60.);
-          gyro[2] = (float)(atof(strs[14].c_str()) / 60.);
-          navdata.setAcc(acc);
-          navdata.setGyr(gyro);
-          //navdata.setTime(tnow);
-          //navdata.setTime_s(strs[0] + '.' + strs[1]);
-          navdata.setTime_s(strs[0]);
-#ifdef WRITE_ON_STDOUT
-          std::cout << navdata.to_string() << std::endl;
-#else
-          logfile << navdata.to_string() << std::endl;
-#endif
-
-#if defined (USE_HOST_MEMORY)
-          if (navdata.getAcc_s()[2].size()) {
-            data[indiceData].d[0] = (double)counter++;
-            data[indiceData].set(navdata.getInertial());
-            indiceData = (indiceData + 1) % DIMENSIONE_MAX;
-          }
-#endif
-        }
-
-#ifdef ENABLE_SLEEP
-        boost::this_thread::sleep(boost::posix_time::microseconds((int64_t)(SLEEP_TIME_MICROSECONDS)));
-#endif
-      }
-    }
-
-    catch (boost::system::system_error& e)
-    {
-      std::cout << "Error: " << e.what() << std::endl;
-      return 1;
-    }
-    break;
+    if (pipeline) pipeline->stop();
+    sink->flush();
+    std::cout << "Error: " << e.what() << std::endl;
+    return 1;
   }
 
-  default:
-    std::cout << "Error: unidentified object #" << systeminfo << std::endl;
-    break;
-  }
+  if (pipeline) pipeline->stop();
+  sink->flush();
+  std::cout << "Frames decoded: " << decoder->framesAccepted() << ", rejected: " << decoder->framesRejected() << ", dropped: " << decoder->framesDropped() << ", ignored: " << decoder->framesIgnored() << std::endl;
+  sink->report(std::cout);
+  if (pipeline) pipeline->report(std::cout);
 
 #ifndef WRITE_ON_STDOUT
   logfile.close();
@@ -860,6 +381,3 @@ int main(int argc, char ** argv)
 
   return 0;
 }
-
-
-
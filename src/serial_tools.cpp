@@ -6,6 +6,11 @@
 
 #include "serial_tools.h"
 
+#if defined(__linux__)
+#include <linux/serial.h>
+#include <sys/ioctl.h>
+#endif
+
 
 TimeoutSerial::ReadSetupParameters::ReadSetupParameters() : fixedSize(false), delim(""), data(0), size(0) {}
 TimeoutSerial::ReadSetupParameters::ReadSetupParameters(const std::string& delim) : fixedSize(false), delim(delim), data(0), size(0) { }
@@ -24,21 +29,12 @@ void SimpleSerial::writeString(std::string s)
 std::string SimpleSerial::readLine()
 {
   using namespace boost;
-  char c;
-  std::string result;
-  for (;;)
-  {
-    asio::read(serial, asio::buffer(&c, 1));
-    switch (c)
-    {
-    case '\r':
-      break;
-    case '\n':
-      return result;
-    default:
-      result += c;
-    }
-  }
+  size_t length = asio::read_until(serial, readData, '\n');
+  std::string result(length, '\0');
+  readData.sgetn(&result[0], length);
+  result.resize(length - 1);
+  result.erase(std::remove(result.begin(), result.end(), '\r'), result.end());
+  return result;
 }
 
 timeout_exception::timeout_exception(const std::string& arg) : runtime_error(arg) {}
@@ -104,9 +100,8 @@ void TimeoutSerial::read(char *data, size_t size)
 {
   if (readData.size() > 0)//If there is some data from a previous read
   {
-    std::istream is(&readData);
     size_t toRead = std::min(readData.size(), size);//How many bytes to read?
-    is.read(data, toRead);
+    readData.sgetn(data, toRead);
     data += toRead;
     size -= toRead;
     if (size == 0) return;//If read data was enough, just return
@@ -132,6 +127,7 @@ void TimeoutSerial::read(char *data, size_t size)
     {
     case resultSuccess:
       timer.cancel();
+      readData.sgetn(data, size);//The rest stays in readData
       return;
     case resultTimeout:
       port.cancel();
@@ -210,7 +206,8 @@ void TimeoutSerial::performReadSetup(const ReadSetupParameters& param)
 {
   if (param.fixedSize)
   {
-    boost::asio::async_read(port, boost::asio::buffer(param.data, param.size), boost::bind(
+    // into readData, which takes whatever the port has beyond param.size
+    boost::asio::async_read(port, readData, boost::asio::transfer_at_least(param.size - readData.size()), boost::bind(
       &TimeoutSerial::readCompleted, this, boost::asio::placeholders::error,
       boost::asio::placeholders::bytes_transferred));
   }
@@ -255,8 +252,8 @@ void TimeoutSerial::readCompleted(const boost::system::error_code& error,
   result = resultError;
 }
 
-SerialOptions::SerialOptions() : device(), baudrate(9600), timeout(seconds(0)), parity(noparity), csize(8), flow(noflow), stop(one) {}
-SerialOptions::SerialOptions(const std::string& device, unsigned int baudrate, time_duration timeout = seconds(0), Parity parity = noparity, unsigned char csize = 8, FlowControl flow = noflow, StopBits stop = one) : device(device), baudrate(baudrate), timeout(timeout), parity(parity), csize(csize), flow(flow), stop(stop) {}
+SerialOptions::SerialOptions() : device(), baudrate(9600), timeout(seconds(0)), parity(noparity), csize(8), flow(noflow), stop(one), lowLatency(false), readChunkSize(READ_CHUNK_SIZE) {}
+SerialOptions::SerialOptions(const std::string& device, unsigned int baudrate, time_duration timeout = seconds(0), Parity parity = noparity, unsigned char csize = 8, FlowControl flow = noflow, StopBits stop = one) : device(device), baudrate(baudrate), timeout(timeout), parity(parity), csize(csize), flow(flow), stop(stop), lowLatency(false), readChunkSize(READ_CHUNK_SIZE) {}
 
 void SerialOptions::setDevice(const std::string& device) { this->device = device; }
 std::string SerialOptions::getDevice() const { return this->device; }
@@ -297,12 +294,52 @@ SerialOptions::FlowControl SerialOptions::getFlowControl() const { return this->
 void SerialOptions::setStopBits(StopBits stop) { this->stop = stop; }
 SerialOptions::StopBits SerialOptions::getStopBits() const { return this->stop; }
 
+/**
+* Setter and getter for low latency mode
+*/
+void SerialOptions::setLowLatency(bool lowLatency) { this->lowLatency = lowLatency; }
+bool SerialOptions::getLowLatency() const { return this->lowLatency; }
+
+/**
+* Setter and getter for read chunk size
+*/
+void SerialOptions::setReadChunkSize(size_t size) { this->readChunkSize = std::max<size_t>(size, 1); }
+size_t SerialOptions::getReadChunkSize() const { return this->readChunkSize; }
+
+
+size_t tune_serial_port(boost::asio::serial_port::native_handle_type handle, const SerialOptions& options)
+{
+  size_t failed = 0;
+#if defined(__linux__)
+  if (options.getLowLatency())
+  {
+    struct serial_struct serial;
+    bool applied = ioctl(handle, TIOCGSERIAL, &serial) == 0;
+    serial.flags |= ASYNC_LOW_LATENCY;
+    if (applied) applied = ioctl(handle, TIOCSSERIAL, &serial) == 0;
+    if (!applied)
+    {
+      std::cerr << "Warning: " << options.getDevice() << " does not support low latency mode (" << strerror(errno) << ")" << std::endl;
+      failed++;
+    }
+  }
+#else
+  (void)handle;
+  if (options.getLowLatency())
+  {
+    std::cerr << "Warning: low latency mode is only available on Linux" << std::endl;
+    failed++;
+  }
+#endif
+  return failed;
+}
+
 
 
 SerialDeviceImpl::SerialDeviceImpl(const SerialOptions& options)
   : io(), port(io), timer(io), timeout(options.getTimeout()),
   result(resultError), bytesTransferred(0), readBuffer(0),
-  readBufferSize(0)
+  readBufferSize(0), chunk(options.getReadChunkSize()), chunkBegin(0), chunkEnd(0)
 {
   try {
     //For this code to work, there should always be a timeout, so the
@@ -367,6 +404,8 @@ SerialDeviceImpl::SerialDeviceImpl(const SerialOptions& options)
   {
     throw std::ios::failure(e.what());
   }
+
+  tune_serial_port(port.native_handle(), options);
 }
 
 
@@ -376,6 +415,20 @@ SerialDevice::SerialDevice(const SerialOptions& options)
 
 
 std::streamsize SerialDevice::read(char *s, std::streamsize n)
+{
+  if (pImpl->chunkBegin == pImpl->chunkEnd)
+  {
+    if ((size_t)n >= pImpl->chunk.size()) return readSome(s, n);//Large reads skip the copy
+    pImpl->chunkBegin = 0;
+    pImpl->chunkEnd = (size_t)readSome(pImpl->chunk.data(), (std::streamsize)pImpl->chunk.size());
+  }
+  size_t count = std::min((size_t)n, pImpl->chunkEnd - pImpl->chunkBegin);
+  memcpy(s, pImpl->chunk.data() + pImpl->chunkBegin, count);
+  pImpl->chunkBegin += count;
+  return (std::streamsize)count;
+}
+
+std::streamsize SerialDevice::readSome(char *s, std::streamsize n)
 {
   pImpl->result = resultInProgress;
   pImpl->bytesTransferred = 0;
@@ -532,6 +585,11 @@ bool AsyncSerial::isOpen() const
   return pimpl->open;
 }
 
+size_t AsyncSerial::tune(const SerialOptions& options)
+{
+  return tune_serial_port(pimpl->port.native_handle(), options);
+}
+
 bool AsyncSerial::errorStatus() const
 {
   boost::lock_guard<boost::mutex> l(pimpl->errorMutex);
@@ -838,6 +896,11 @@ bool AsyncSerial::isOpen() const
   return pimpl->open;
 }
 
+size_t AsyncSerial::tune(const SerialOptions& options)
+{
+  return tune_serial_port(pimpl->fd, options);
+}
+
 bool AsyncSerial::errorStatus() const
 {
   boost::lock_guard<boost::mutex> l(pimpl->errorMutex);
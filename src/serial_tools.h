@@ -43,6 +43,7 @@ public:
   /**
   * Blocks until a line is received from the serial device.
   * Eventual '\n' or '\r\n' characters at the end of the string are removed.
+  * The port is read in chunks: bytes past the end of the line are kept for the next call.
   * \return a string containing the received line
   * \throws boost::system::system_error on failure
   */
@@ -51,6 +52,7 @@ public:
 private:
   boost::asio::io_context io;
   boost::asio::serial_port serial;
+  boost::asio::streambuf readData;  ///< Holds data read past the last line
 };
 
 class timeout_exception : public std::runtime_error
@@ -164,6 +166,8 @@ public:
 
   /**
   * Read some data, blocking
+  * Whatever the port delivers beyond size bytes is kept for the next reads,
+  * so that a sequence of small reads costs one time-out per chunk received.
   * \param data array of char to be read through the serial device
   * \param size array size
   * \return number of character actually read 0<=return<=size
@@ -344,6 +348,23 @@ public:
   void setStopBits(StopBits stop);
   StopBits getStopBits() const;
 
+  /**
+  * Setter and getter for the low latency mode of the driver (ASYNC_LOW_LATENCY,
+  * Linux only): USB adapters hand over data as it arrives instead of every
+  * few milliseconds
+  */
+  void setLowLatency(bool lowLatency);
+  bool getLowLatency() const;
+
+  /**
+  * Setter and getter for the most bytes taken from the driver by each read,
+  * the size of the user-space chunk of SerialDevice and of the serial_reader
+  * -m readers. The driver's own receive buffer is left as it is: a tty has
+  * no portable setting for it.
+  */
+  void setReadChunkSize(size_t size);
+  size_t getReadChunkSize() const;
+
 private:
   std::string device;
   unsigned int baudrate;
@@ -352,8 +373,20 @@ private:
   unsigned char csize;
   FlowControl flow;
   StopBits stop;
+  bool lowLatency;
+  size_t readChunkSize;
 };
 
+/**
+* Apply the Linux specific options (low latency) to an open port.
+* An option the driver refuses is reported on std::cerr and skipped: the port
+* keeps working with the driver defaults. The termios VMIN/VTIME thresholds are
+* not offered: asio opens ports non-blocking, and the kernel ignores them there.
+* \param handle native handle of the port
+* \return number of options that could not be applied
+*/
+size_t tune_serial_port(boost::asio::serial_port::native_handle_type handle, const SerialOptions& options);
+
 
 class SerialDeviceImpl : private boost::noncopyable
 {
@@ -372,6 +405,9 @@ public:
   std::streamsize bytesTransferred; ///< Used by async read callback
   char *readBuffer; ///< Used to hold read data
   std::streamsize readBufferSize; ///< Size of read data buffer
+  std::vector<char> chunk; ///< Bytes read from the port and not yet returned
+  size_t chunkBegin; ///< First byte of chunk not yet returned
+  size_t chunkEnd; ///< End of the valid bytes in chunk
 };
 
 
@@ -404,6 +440,9 @@ public:
   * allows to catch any exception.
   * Use the clear() member function to go on reading after an exception was
   * thrown.
+  * Small reads are served from an internal buffer, refilled with up to
+  * READ_CHUNK_SIZE bytes under a single time-out; larger ones go straight
+  * to the port.
   * \param s where to store read characters
   * \param n max number of characters to read
   * \return number of character read
@@ -423,6 +462,12 @@ public:
   std::streamsize write(const char *s, std::streamsize n);
 
 private:
+  /**
+  * Read some bytes from the port, blocking up to the time-out
+  * \return number of bytes read, at least one
+  */
+  std::streamsize readSome(char *s, std::streamsize n);
+
   /**
   * Callback called either when the read time-out is expired or cancelled.
   * If called because time-out expired, sets result to resultTimeoutExpired
@@ -517,6 +562,12 @@ public:
   */
   bool isOpen() const;
 
+  /**
+  * Apply the Linux specific options to the open port, see tune_serial_port()
+  * \return number of options that could not be applied
+  */
+  size_t tune(const SerialOptions& options);
+
   /**
   * \return true if error were found
   */
@@ -3,32 +3,81 @@
 
 #include "draw.h"
 #include "datalogger.h"
+#include "shared_channel.h"
 
 using namespace boost::algorithm;
 
-extern Data **data;
-extern int * indiceData;
+extern std::vector<SharedChannel> channels;
 
 extern Frame *scene;
 
+#define VIEWER_WAIT_MS 100    // how long a closed viewer may wait for its watcher threads
 
-void idle_cb(void*) {
+static std::atomic<bool> redraw_pending(false);
+static std::atomic<bool> viewer_closed(false);
+
+
+void redraw_cb(void*) {
+  redraw_pending = false;
   scene->redraw();
 }
 
+// sleeps on the ring of a box and wakes the FLTK loop when new samples are published,
+// so that the viewer costs nothing while the boxes are silent
+void watch_channel(SharedChannel channel) {
+  uint64_t seen = channel.head();
+  while (!viewer_closed) {
+    if (!channel.wait(seen, VIEWER_WAIT_MS)) continue;
+    seen = channel.head();
+    if (!redraw_pending.exchange(true)) Fl::awake(redraw_cb, 0);
+  }
+}
+
 
 
 int main(int argc, char **argv) {
 
 #if defined (USE_HOST_MEMORY)
+  RingOptions ring_options;
+  double ring_seconds = 0.;
+  for (int i = 1; i < argc; i++) {
+    if ((argv[i][0] == '-') || (argv[i][0] == '/')) {
+      switch (tolower(argv[i][1])) {
+      case 'n':
+        ring_options.capacity = strtoull(argv[++i], NULL, 10);
+        break;
+      case 'w':
+        ring_seconds = atof(argv[++i]);
+        break;
+      case 'r':
+        ring_options.sample_rate = atof(argv[++i]);
+        break;
+      case 'l':
+        ring_options.huge_pages = true;
+        break;
+      case 'c':
+        ring_options.compact = true;
+        break;
+      default:
+        std::cout << argv[i] << " not recognized" << std::endl;
+        break;
+      }
+    }
+  }
+  if (ring_seconds > 0. && ring_options.sample_rate > 0.) ring_options = RingOptions::window(ring_seconds, ring_options.sample_rate, ring_options.huge_pages, ring_options.compact);
+
   std::vector<std::string> box_types({ "Infomobility", "MagnetiMarelli", "Texa", "ViaSat", "MetaSystem", "UBX", "Octo", "NMEA", "MagnetiMarelli_v2" });
-  data = new Data*[box_types.size()];
-  indiceData = new int[box_types.size()];
 
-  unsigned int counter = 0;
+  // rings already created by a running serial_reader are kept, stale ones of another layout replaced
   for (auto box_type : box_types) {
-    remove_host_memory(box_type.c_str());
-    data[counter++] = (Data*)allocate_host_memory(box_type.c_str(), (DIMENSIONE_MAX+1)*sizeof(Data));
+    try {
+      channels.push_back(SharedChannel(box_type, ring_options));
+    }
+    catch (std::exception& e) {
+      std::cout << box_type << ": " << e.what() << ", recreating it" << std::endl;
+      remove_host_memory(box_type.c_str());
+      channels.push_back(SharedChannel(box_type, ring_options));
+    }
   }
 
   //replacement for system("Pause");
@@ -36,8 +85,12 @@ int main(int argc, char **argv) {
   //std::cin.ignore();
 
   CreateMyWindow();
-  Fl::add_idle(idle_cb, 0);
+  Fl::lock();
+  boost::thread_group watchers;
+  for (auto& channel : channels) watchers.create_thread(boost::bind(watch_channel, channel));
   Fl::run();
+  viewer_closed = true;
+  watchers.join_all();
 #else
   std::cout << "This program can only work with shared memory enabled" << std::endl;
 #endif
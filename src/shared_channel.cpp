@@ -0,0 +1,105 @@
+// Copyright 2014, 2015 Stefano Sinigardi, Alessandro Fabbri
+// for any question, please mail stefano.sinigardi@gmail.com
+
+#include "shared_channel.h"
+
+#if defined(USE_HOST_MEMORY)
+SharedChannel::SharedChannel() {}
+
+SharedChannel::SharedChannel(const std::string& name, const RingOptions& options) : channel_name(name) {
+  bool created = false;
+  segment = map_host_memory(name.c_str(), options.segmentSize(), created, options.huge_pages);
+  if (created) {
+    if (options.compact) compact_samples = CompactSampleRing::create(segment->address(), options.capacity, options.sample_rate, name.c_str());
+    else samples = SampleRing::create(segment->address(), options.capacity, options.sample_rate, name.c_str());
+    return;
+  }
+
+  // the creator may still be sizing the segment, which then maps empty
+  for (int waited = 0; segment->size() < sizeof(SampleRingHeader); waited++) {
+    segment.reset();
+    if (waited == SAMPLE_RING_ATTACH_MS) throw std::runtime_error("shared memory segment too small for a sample ring");
+    boost::this_thread::sleep(boost::posix_time::milliseconds(1));
+    segment = map_host_memory(name.c_str(), 0, created);
+  }
+  if (sample_ring_layout(segment->address()) == RECORD_LAYOUT_COMPACT) compact_samples = CompactSampleRing::attach(segment->address(), segment->size());
+  else samples = SampleRing::attach(segment->address(), segment->size());
+}
+
+bool SharedChannel::isOpen() const {
+  return segment && base().valid();
+}
+
+bool SharedChannel::isCompact() const {
+  return compact_samples.valid();
+}
+
+const std::string& SharedChannel::name() const {
+  return channel_name;
+}
+
+SampleRing& SharedChannel::ring() {
+  return samples;
+}
+
+const SampleRing& SharedChannel::ring() const {
+  return samples;
+}
+
+CompactSampleRing& SharedChannel::compactRing() {
+  return compact_samples;
+}
+
+const CompactSampleRing& SharedChannel::compactRing() const {
+  return compact_samples;
+}
+
+SampleRingBase& SharedChannel::base() {
+  if (isCompact()) return compact_samples;
+  return samples;
+}
+
+const SampleRingBase& SharedChannel::base() const {
+  if (isCompact()) return compact_samples;
+  return samples;
+}
+
+uint64_t SharedChannel::capacity() const {
+  return base().capacity();
+}
+
+uint64_t SharedChannel::head() const {
+  return base().head();
+}
+
+void SharedChannel::push(const Record& record) {
+  if (!isCompact()) samples.push(record);
+  else if (record.isSet(POS_AX) || record.isSet(POS_GX)) compact_samples.push(CompactRecord(record));
+}
+
+uint64_t SharedChannel::publish() {
+  return base().publish();
+}
+
+bool SharedChannel::wait(uint64_t seen, unsigned int timeout_ms) const {
+  return base().wait(seen, timeout_ms);
+}
+
+size_t SharedChannel::readLatest(Record *records, size_t count, uint64_t& first) {
+  if (!isCompact()) return samples.readLatest(records, count, first);
+  compact_window.resize(count);
+  size_t copied = compact_samples.readLatest(compact_window.data(), count, first);
+  for (size_t i = 0; i < copied; i++) records[i] = compact_window[i].expand();
+  return copied;
+}
+
+void SharedChannel::close() {
+  samples = SampleRing();
+  compact_samples = CompactSampleRing();
+  segment.reset();
+}
+
+size_t SharedChannel::mappings() {
+  return host_memory_mappings();
+}
+#endif
@@ -0,0 +1,103 @@
+// Copyright 2014, 2015 Stefano Sinigardi, Alessandro Fabbri
+// for any question, please mail stefano.sinigardi@gmail.com
+
+#pragma once
+
+#include "sample_ring.h"
+#include <string>
+#include <vector>
+
+#if defined(USE_HOST_MEMORY)
+/**
+* A sample ring in a named shared memory segment, mapped for as long as a
+* channel refers to it. Channels opened on the same name in one process share
+* a single mapping, so reconnecting does not map the segment again; the
+* mapping is released as soon as the last channel on it is closed or destroyed.
+* Copies of a channel share the mapping and the ring position.
+* The ring holds either Record or CompactRecord, as chosen by its creator; the
+* record functions of the channel work with both, or ring() and compactRing()
+* give typed access to the one in use.
+*/
+class SharedChannel {
+public:
+  SharedChannel();
+
+  /**
+  * Open the ring in segment name, creating it with the given options if it
+  * does not exist yet: producers and viewers can start in any order, and
+  * whoever comes second attaches with the layout found in the header.
+  * \throw std::runtime_error if the segment exists but holds an incompatible ring
+  */
+  explicit SharedChannel(const std::string& name, const RingOptions& options = RingOptions());
+
+  /**
+  * \return false for a default-constructed or closed channel
+  */
+  bool isOpen() const;
+
+  const std::string& name() const;
+
+  /**
+  * \return true if the ring holds CompactRecord
+  */
+  bool isCompact() const;
+
+  /**
+  * \return the ring of Record, valid until the channel is closed; invalid if isCompact()
+  */
+  SampleRing& ring();
+  const SampleRing& ring() const;
+
+  /**
+  * \return the ring of CompactRecord, valid until the channel is closed; invalid unless isCompact()
+  */
+  CompactSampleRing& compactRing();
+  const CompactSampleRing& compactRing() const;
+
+  uint64_t capacity() const;
+  uint64_t head() const;
+
+  /**
+  * Producer: write the next record, compacted if the ring is compact; records
+  * without inertial values are left out of compact rings
+  */
+  void push(const Record& record);
+
+  /**
+  * Producer: make the records pushed so far visible
+  * \return new head
+  */
+  uint64_t publish();
+
+  /**
+  * Consumer: sleep until the head moves past seen, see SampleRingBase::wait()
+  */
+  bool wait(uint64_t seen, unsigned int timeout_ms) const;
+
+  /**
+  * Consumer: copy the last records published, oldest first, expanding compact ones
+  * \return number of records copied, see BasicSampleRing::readLatest()
+  */
+  size_t readLatest(Record *records, size_t count, uint64_t& first);
+
+  /**
+  * Drop this channel's reference to the mapping, unmapping it if it was the last one
+  */
+  void close();
+
+  /**
+  * \return number of shared memory segments mapped by this process
+  */
+  static size_t mappings();
+
+private:
+  std::string channel_name;
+  boost::shared_ptr<SharedSegment> segment;
+  SampleRing samples;
+  CompactSampleRing compact_samples;
+  std::vector<CompactRecord> compact_window;  ///< Scratch buffer of readLatest() on compact rings
+
+  SampleRingBase& base();
+  const SampleRingBase& base() const;
+};
+#endif
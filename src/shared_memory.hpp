@@ -1,7 +1,73 @@
 #pragma once
 
 #if defined(USE_HOST_MEMORY)
+#ifdef _WIN32
+#define BOOST_NO_RVALUE_REFERENCES
+#include <boost/interprocess/windows_shared_memory.hpp>
+#else
+#include <boost/interprocess/shared_memory_object.hpp>
+#endif
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/utility.hpp>
+#include <memory>
+#include <string>
+using namespace boost::interprocess;
+
+/**
+* A shared memory segment mapped in this process, unmapped when destroyed.
+* Obtained from map_host_memory(), which hands out the same mapping to every
+* user of a name instead of mapping the segment again.
+*/
+class SharedSegment : private boost::noncopyable {
+public:
+  /**
+  * Create the segment, failing if it exists
+  * \throw interprocess_exception with already_exists_error if it does
+  */
+  SharedSegment(create_only_t, const char* name, size_t bytes);
+  /**
+  * Map the whole of an existing segment. One its creator has not sized yet
+  * is left unmapped, with size() 0 and a null address()
+  */
+  SharedSegment(open_only_t, const char* name);
+
+  void* address() const;
+  size_t size() const;
+  const std::string& name() const;
+
+private:
+  std::string segment_name;
+  std::unique_ptr<mapped_region> region;
+};
+
+/**
+* Map segment name, sharing the mapping with the other users in this process.
+* \param bytes size of the segment if it has to be created, 0 to only open an existing one
+* \param created set to true if this call created the segment
+* \param huge_pages ask the kernel to back a created segment with transparent huge pages, where supported
+* \return the mapping, released when the last pointer to it goes away; empty, with size() 0,
+* if another process has just created the segment and not sized it yet
+*/
+boost::shared_ptr<SharedSegment> map_host_memory(const char* name, size_t bytes, bool& created, bool huge_pages = false);
+
+/**
+* \return number of segments currently mapped through map_host_memory()
+*/
+size_t host_memory_mappings();
+
+/**
+* Unlink the segment; the legacy mapping kept by allocate_host_memory() and get_host_allocated_memory() is released
+*/
 void remove_host_memory(const char*);
+
+/**
+* Create the segment, replacing any previous one, and keep it mapped until remove_host_memory()
+*/
 void* allocate_host_memory(const char*, size_t);
+
+/**
+* Map an existing segment and keep it mapped until remove_host_memory(); calling it again returns the same address
+*/
 void* get_host_allocated_memory(const char*);
 #endif
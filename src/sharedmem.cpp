@@ -5,10 +5,99 @@
 #include "shared_memory.hpp"
 #include "data.hpp"
 
+#if defined(USE_HOST_MEMORY) && !defined(_WIN32)
+#include <sys/mman.h>
+#endif
+#include <map>
+
 #if defined(USE_HOST_MEMORY)
 
+SharedSegment::SharedSegment(create_only_t, const char* name, size_t bytes) : segment_name(name)
+{
+#ifdef _WIN32
+  windows_shared_memory shm(create_only, name, read_write, bytes);
+#else
+  shared_memory_object shm(create_only, name, read_write);
+  shm.truncate(bytes);
+#endif
+  region.reset(new mapped_region(shm, read_write));
+}
+
+
+SharedSegment::SharedSegment(open_only_t, const char* name) : segment_name(name)
+{
+#ifdef _WIN32
+  windows_shared_memory shm(open_only, name, read_write);
+#else
+  shared_memory_object shm(open_only, name, read_write);
+  offset_t bytes = 0;
+  if (!shm.get_size(bytes) || bytes == 0) return;   // created, not sized yet
+#endif
+  region.reset(new mapped_region(shm, read_write));
+}
+
+
+void* SharedSegment::address() const { return region ? region->get_address() : NULL; }
+size_t SharedSegment::size() const { return region ? region->get_size() : 0; }
+const std::string& SharedSegment::name() const { return segment_name; }
+
+
+static boost::mutex host_memory_mutex;
+static std::map<std::string, boost::weak_ptr<SharedSegment> > host_memory_mapped;   // every live mapping, by name
+static std::map<std::string, boost::shared_ptr<SharedSegment> > host_memory_legacy; // kept for the void* interface
+
+
+boost::shared_ptr<SharedSegment> map_host_memory(const char* name, size_t bytes, bool& created, bool huge_pages)
+{
+  boost::lock_guard<boost::mutex> lock(host_memory_mutex);
+  created = false;
+
+  boost::shared_ptr<SharedSegment> segment;
+  auto found = host_memory_mapped.find(name);
+  if (found != host_memory_mapped.end()) segment = found->second.lock();
+  if (segment) return segment;
+
+  for (auto it = host_memory_mapped.begin(); it != host_memory_mapped.end();) {
+    if (it->second.expired()) it = host_memory_mapped.erase(it);
+    else ++it;
+  }
+
+  if (bytes) {
+    try {
+      segment.reset(new SharedSegment(create_only, name, bytes));
+      created = true;
+#if defined(MADV_HUGEPAGE)
+      if (huge_pages) madvise(segment->address(), segment->size(), MADV_HUGEPAGE);
+#endif
+    }
+    catch (interprocess_exception& e) {
+      if (e.get_error_code() != already_exists_error) throw;
+    }
+  }
+  if (!segment) segment.reset(new SharedSegment(open_only, name));
+
+  // an unsized segment is not handed to the next users, they map it again
+  if (segment->size()) host_memory_mapped[name] = segment;
+  return segment;
+}
+
+
+size_t host_memory_mappings()
+{
+  boost::lock_guard<boost::mutex> lock(host_memory_mutex);
+  size_t count = 0;
+  for (auto& mapping : host_memory_mapped) count += mapping.second.expired() ? 0 : 1;
+  return count;
+}
+
+
 void remove_host_memory(const char* name)
 {
+  {
+    boost::lock_guard<boost::mutex> lock(host_memory_mutex);
+    host_memory_legacy.erase(name);
+    host_memory_mapped.erase(name);   // current users keep their mapping, the next ones get a new segment
+  }
 #if !defined(_WIN32)
   bool non_esiste = shared_memory_object::remove(name);
   if (!non_esiste) std::cout << " ho rimosso " << name << "  \n";
@@ -22,28 +111,21 @@ void* allocate_host_memory(const char* name, size_t bytes)
 {
   remove_host_memory(name);
 
-#ifdef _WIN32
-  windows_shared_memory* shm = new windows_shared_memory(create_only, name, read_write, bytes);
-#else
-  shared_memory_object* shm = new shared_memory_object(create_only, name, read_write);
-  shm->truncate(bytes);
-#endif
-
-  mapped_region* region = new mapped_region(*shm, read_write);//, 0, bytes-1);
-  return static_cast<void*>(region->get_address());
+  bool created;
+  boost::shared_ptr<SharedSegment> segment = map_host_memory(name, bytes, created);
+  boost::lock_guard<boost::mutex> lock(host_memory_mutex);
+  host_memory_legacy[name] = segment;
+  return segment->address();
 }
 
 
 void* get_host_allocated_memory(const char* name){
-
-#ifdef _WIN32
-  windows_shared_memory shm(open_only, name, read_write);
-#else
-  shared_memory_object shm(open_only, name, read_write);
-#endif
-
-  mapped_region* region = new mapped_region(shm, read_write); //or read_only
-  return static_cast<void*>(region->get_address());
+  bool created;
+  boost::shared_ptr<SharedSegment> segment = map_host_memory(name, 0, created);
+  if (!segment->size()) throw std::runtime_error(std::string("shared memory segment ") + name + " not sized yet");
+  boost::lock_guard<boost::mutex> lock(host_memory_mutex);
+  host_memory_legacy[name] = segment;
+  return segment->address();
 }
 #endif
 
@@ -56,3 +138,42 @@ void Data::setAcc(const std::array<double,3>& data) {
   for (int i = 1; i < 4; i++) d[i] = data[i - 1];
 }
 
+
+Record::Record() : timestamp(0), lat(0), lon(0), alt(0.f), speed(0.f), heading(0), hdop(0), valid(0), quality(0), reserved(0) {
+  std::fill(inertial, inertial + 6, 0.f);
+}
+
+bool Record::isSet(int pos) const {
+  return (valid & (1u << pos)) != 0;
+}
+
+double Record::getLat() const {
+  return lat * 1e-7;
+}
+
+double Record::getLon() const {
+  return lon * 1e-7;
+}
+
+double Record::getHead() const {
+  return heading * 1e-2;
+}
+
+double Record::getHDOP() const {
+  return hdop * 1e-2;
+}
+
+CompactRecord::CompactRecord() : milliseconds(0) {
+  std::fill(inertial, inertial + 6, 0.f);
+}
+
+CompactRecord::CompactRecord(const Record& record) : milliseconds((uint32_t)(record.timestamp / 1000000)) {
+  std::copy(record.inertial, record.inertial + 6, inertial);
+}
+
+Record CompactRecord::expand() const {
+  Record record;
+  std::copy(inertial, inertial + 6, record.inertial);
+  for (int pos = POS_AX; pos <= POS_GZ; pos++) record.valid |= (uint16_t)(1u << pos);
+  return record;
+}
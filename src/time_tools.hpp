@@ -0,0 +1,123 @@
+// Copyright 2014, 2015 Stefano Sinigardi, Alessandro Fabbri
+// for any question, please mail stefano.sinigardi@gmail.com
+
+#pragma once
+
+#include "datalogger.h"
+#include <chrono>
+#include <cstdint>
+
+#define NANOSECONDS_PER_SECOND  INT64_C(1000000000)
+#define SECONDS_PER_DAY         86400
+
+/*
+* Proleptic Gregorian calendar in UTC, without the C library: no timezone
+* database, no locks, usable in constant expressions. Years are counted in
+* 400-year eras of 146097 days starting on March 1st, so that the leap day
+* is the last day of the year (H. Hinnant, "chrono-Compatible Low-Level Date Algorithms").
+*/
+
+constexpr int64_t civil_era(int64_t year){
+  return (year >= 0 ? year : year - 399) / 400;
+}
+
+constexpr unsigned int civil_day_of_year(unsigned int month, unsigned int day){
+  return (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+}
+
+constexpr unsigned int civil_day_of_era(unsigned int year_of_era, unsigned int day_of_year){
+  return year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+}
+
+constexpr int64_t civil_days_from_march(int64_t year, unsigned int month, unsigned int day){
+  return civil_era(year) * 146097 + (int64_t)civil_day_of_era((unsigned int)(year - civil_era(year) * 400), civil_day_of_year(month, day)) - 719468;
+}
+
+/**
+* \param year full year, e.g. 2015
+* \param month 1 to 12
+* \param day 1 to 31
+* \return days since 1970-01-01
+*/
+constexpr int64_t days_from_civil(int64_t year, unsigned int month, unsigned int day){
+  return civil_days_from_march(month <= 2 ? year - 1 : year, month, day);
+}
+
+/**
+* \return nanoseconds since 1970-01-01 00:00:00 UTC of the given UTC date and time;
+* nano may be negative or exceed a second, as in UBX NAV-PVT
+*/
+constexpr int64_t utc_nanoseconds(int64_t year, unsigned int month, unsigned int day, unsigned int hour, unsigned int minute, unsigned int second, int64_t nano){
+  return ((days_from_civil(year, month, day) * SECONDS_PER_DAY + hour * 3600 + minute * 60 + second) * NANOSECONDS_PER_SECOND) + nano;
+}
+
+static_assert(days_from_civil(1970, 1, 1) == 0, "days_from_civil epoch");
+static_assert(days_from_civil(2000, 1, 1) * SECONDS_PER_DAY == EPOCH_TIME_2000, "days_from_civil disagrees with EPOCH_TIME_2000");
+static_assert(days_from_civil(2000, 3, 1) - days_from_civil(2000, 2, 28) == 2, "days_from_civil leap day");
+
+
+/**
+* Inverse of days_from_civil
+* \param days days since 1970-01-01
+*/
+void civil_from_days(int64_t days, int64_t& year, unsigned int& month, unsigned int& day){
+  days += 719468;
+  int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+  unsigned int day_of_era = (unsigned int)(days - era * 146097);
+  unsigned int year_of_era = (day_of_era - day_of_era / 1460 + day_of_era / 36524 - day_of_era / 146096) / 365;
+  unsigned int day_of_year = day_of_era - (365 * year_of_era + year_of_era / 4 - year_of_era / 100);
+  unsigned int month_from_march = (5 * day_of_year + 2) / 153;
+  day = day_of_year - (153 * month_from_march + 2) / 5 + 1;
+  month = month_from_march < 10 ? month_from_march + 3 : month_from_march - 9;
+  year = (int64_t)year_of_era + era * 400 + (month <= 2 ? 1 : 0);
+}
+
+//***************************************************************************************************************
+
+/**
+* Host clocks read when a chunk of bytes arrives from the device
+*/
+struct ArrivalStamp {
+  int64_t monotonic;          ///< Nanoseconds of CLOCK_MONOTONIC, for latencies and intervals
+  int64_t realtime;           ///< Nanoseconds since the epoch of CLOCK_REALTIME, to date samples and align boxes
+  ArrivalStamp();
+  /**
+  * \return both clocks, read one after the other
+  */
+  static ArrivalStamp now();
+};
+
+/**
+* \return nanoseconds of a clock that never jumps, with an arbitrary origin
+*/
+int64_t monotonic_nanoseconds(){
+#ifdef _WIN32
+  return (int64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (int64_t)ts.tv_sec * NANOSECONDS_PER_SECOND + ts.tv_nsec;
+#endif
+}
+
+/**
+* \return nanoseconds since the epoch of the wall clock
+*/
+int64_t realtime_nanoseconds(){
+#ifdef _WIN32
+  return (int64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_REALTIME, &ts);
+  return (int64_t)ts.tv_sec * NANOSECONDS_PER_SECOND + ts.tv_nsec;
+#endif
+}
+
+ArrivalStamp::ArrivalStamp() : monotonic(0), realtime(0) {}
+
+ArrivalStamp ArrivalStamp::now(){
+  ArrivalStamp stamp;
+  stamp.monotonic = monotonic_nanoseconds();
+  stamp.realtime = realtime_nanoseconds();
+  return stamp;
+}
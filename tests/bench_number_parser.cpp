@@ -0,0 +1,73 @@
+// Microbenchmark: parse_decimal against atof/strtod on the numeric fields of
+// log lines in the formats handled by the text decoders.
+// Not part of ctest: build it and run it on the target machine.
+#include "number_tools.h"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+static const char* sample_lines[] = {
+    // Texa
+    "1523;2015;6;15;12;0;0;123;44.4912;11.3512;54.2;12.5;0.0123;-0.9812;0.1044;-0.0021;0.0154;1.2044;0;0;1",
+    "1524;2015;6;15;12;0;0;133;44.4913;11.3513;54.3;12.6;0.0141;-0.9799;0.1021;-0.0034;0.0162;1.1987;0;0;1",
+    // MetaSystem_v2
+    "1434369600;120000000;44.491234;11.351234;1;1;1.20;12500;90.5;12;-981;104;-2;15;1204;1523;1434369600",
+    "1434369600;220000000;44.491236;11.351239;1;1;1.20;12510;90.6;14;-979;102;-3;16;1198;1524;1434369600",
+    // NMEA
+    "$GPRMC,120000.00,A,4429.4000,N,01121.0000,E,10.0,45.0,150615,,,A*6B",
+    "$GPGGA,120000.00,4429.4000,N,01121.0000,E,1,08,0.9,54.0,M,46.9,M,,*4F",
+    // ViaSat
+    "$A+00120-00250+01000*4F",
+};
+
+int main() {
+    // Collect the numeric fields once, both as views and as null terminated strings for atof/strtod
+    std::vector<std::string> lines;
+    for (size_t i = 0; i < sizeof(sample_lines) / sizeof(sample_lines[0]); i++) lines.push_back(sample_lines[i]);
+    std::vector<std::string> fields;
+    for (size_t i = 0; i < lines.size(); i++) {
+        const std::string& line = lines[i];
+        size_t start = 0;
+        while (start <= line.size()) {
+            size_t stop = line.find_first_of(";,*", start);
+            if (stop == std::string::npos) stop = line.size();
+            std::string field = line.substr(start, stop - start);
+            double value;
+            if (parse_decimal(field.data(), field.data() + field.size(), value) == numberOk) fields.push_back(field);
+            start = stop + 1;
+        }
+    }
+
+    const int rounds = 200000;
+    const double total = (double)rounds * fields.size();
+    volatile double sink = 0;
+    typedef std::chrono::steady_clock clock;
+
+    clock::time_point t0 = clock::now();
+    for (int r = 0; r < rounds; r++)
+        for (size_t i = 0; i < fields.size(); i++) sink = sink + atof(fields[i].c_str());
+    clock::time_point t1 = clock::now();
+    for (int r = 0; r < rounds; r++)
+        for (size_t i = 0; i < fields.size(); i++) sink = sink + strtod(fields[i].c_str(), NULL);
+    clock::time_point t2 = clock::now();
+    for (int r = 0; r < rounds; r++)
+        for (size_t i = 0; i < fields.size(); i++) {
+            double value;
+            parse_decimal(fields[i].data(), fields[i].data() + fields[i].size(), value);
+            sink = sink + value;
+        }
+    clock::time_point t3 = clock::now();
+
+    double ns_atof = std::chrono::duration<double, std::nano>(t1 - t0).count() / total;
+    double ns_strtod = std::chrono::duration<double, std::nano>(t2 - t1).count() / total;
+    double ns_parse = std::chrono::duration<double, std::nano>(t3 - t2).count() / total;
+
+    std::cout << fields.size() << " fields x " << rounds << " rounds" << std::endl;
+    std::cout << "atof          " << ns_atof << " ns/field" << std::endl;
+    std::cout << "strtod        " << ns_strtod << " ns/field" << std::endl;
+    std::cout << "parse_decimal " << ns_parse << " ns/field (" << ns_strtod / ns_parse << "x faster than strtod)" << std::endl;
+    return 0;
+}
@@ -0,0 +1,70 @@
+// Microbenchmark: NavData::format into a caller buffer against the previous
+// to_string, which converted every field with lexical_cast and joined the
+// strings with repeated concatenations.
+// Not part of ctest: build it and run it on the target machine.
+#include "data_tools.hpp"
+#include <chrono>
+#include <iostream>
+
+static std::string legacy_to_string(const NavData& nav) {
+    std::vector<std::string> nav_data(POS_COUNT);
+    nav_data[POS_TIME] = nav.getTime();
+    std::array<double, 6> inertial = nav.getInertial();
+    for (int i = 0; i < 6; i++) nav_data[POS_AX + i] = boost::lexical_cast<std::string>(inertial[i]);
+    NavData copy = nav;
+    nav_data[POS_LAT] = boost::lexical_cast<std::string>(copy.getLat());
+    nav_data[POS_LON] = boost::lexical_cast<std::string>(copy.getLon());
+    nav_data[POS_ALT] = boost::lexical_cast<std::string>(copy.getAlt());
+    nav_data[POS_SPEED] = boost::lexical_cast<std::string>(copy.getSpeed());
+    nav_data[POS_HEAD] = boost::lexical_cast<std::string>(copy.getHead());
+    nav_data[POS_QLT] = boost::lexical_cast<std::string>(copy.getQlt());
+    nav_data[POS_HDOP] = boost::lexical_cast<std::string>(copy.getHDOP());
+    std::string str("");
+    for (auto data : nav_data) str += data + COMMA_SEPARATION_VALUE;
+    return str.substr(0, str.size() - 1);
+}
+
+int main() {
+    NavData nav;
+    nav.setTime_s("2015:6:15:12:0:0.120");
+    double acc[3] = {0.0123, -0.9812, 0.1044};
+    double gyr[3] = {-0.0021, 0.0154, 1.2044};
+    nav.setAcc(acc);
+    nav.setGyr(gyr);
+    nav.setLat(44.4912345);
+    nav.setLon(11.3512345);
+    nav.setAlt(54.2);
+    nav.setSpeed(12.5);
+    nav.setHead(90.5);
+    nav.setQlt(3);
+    nav.setHDOP(1.2);
+
+    const int rounds = 200000;
+    volatile size_t sink = 0;
+    typedef std::chrono::steady_clock clock;
+    RecordSchema schema = RecordSchema::defaults();
+    RecordSchema rounded = RecordSchema::rounded();
+    char buffer[RECORD_MAX_SIZE];
+
+    clock::time_point t0 = clock::now();
+    for (int r = 0; r < rounds; r++) sink = sink + legacy_to_string(nav).size();
+    clock::time_point t1 = clock::now();
+    for (int r = 0; r < rounds; r++) sink = sink + nav.to_string().size();
+    clock::time_point t2 = clock::now();
+    for (int r = 0; r < rounds; r++) sink = sink + nav.format(buffer, sizeof(buffer), schema);
+    clock::time_point t3 = clock::now();
+    for (int r = 0; r < rounds; r++) sink = sink + nav.format(buffer, sizeof(buffer), rounded);
+    clock::time_point t4 = clock::now();
+
+    double ns_legacy = std::chrono::duration<double, std::nano>(t1 - t0).count() / rounds;
+    double ns_string = std::chrono::duration<double, std::nano>(t2 - t1).count() / rounds;
+    double ns_format = std::chrono::duration<double, std::nano>(t3 - t2).count() / rounds;
+    double ns_rounded = std::chrono::duration<double, std::nano>(t4 - t3).count() / rounds;
+
+    std::cout << "record: " << std::string(buffer, nav.format(buffer, sizeof(buffer), schema)) << std::endl;
+    std::cout << "legacy to_string " << ns_legacy << " ns/record" << std::endl;
+    std::cout << "to_string        " << ns_string << " ns/record" << std::endl;
+    std::cout << "format           " << ns_format << " ns/record (" << ns_legacy / ns_format << "x faster than legacy)" << std::endl;
+    std::cout << "format rounded   " << ns_rounded << " ns/record (" << ns_legacy / ns_rounded << "x faster than legacy)" << std::endl;
+    return 0;
+}
@@ -0,0 +1,132 @@
+// Benchmark: small reads from a pseudo-terminal through SerialDevice and
+// SimpleSerial, against the previous code, which armed a time-out and ran the
+// io_context for every read and read lines one character at a time.
+// Reports bytes per second and the CPU used by the reading thread.
+// Not part of ctest: build it and run it on the target machine (Linux only).
+#include "serial_tools.h"
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+static const size_t total_bytes = 4 << 20;
+static const std::string sentence = "$GPRMC,123519.00,A,4807.038,N,01131.000,E,022.4,084.4,230394,003.1,W*6A\r\n";
+
+// the reading side of the previous SerialDevice::read
+class LegacyDevice {
+public:
+    explicit LegacyDevice(const std::string& device) : port(io, device), timer(io) {}
+
+    size_t read(char *s, size_t n) {
+        result = resultInProgress;
+        timer.expires_from_now(boost::posix_time::seconds(SERIAL_PORT_TIMEOUT_SECONDS));
+        timer.async_wait([this](const boost::system::error_code& error) { if (!error && result == resultInProgress) result = resultTimeout; });
+        port.async_read_some(boost::asio::buffer(s, n), [this](const boost::system::error_code& error, size_t bytes) {
+            if (!error) { result = resultSuccess; transferred = bytes; }
+            else if (error != boost::asio::error::operation_aborted) result = resultError;
+        });
+        for (;;) {
+            io.run_one();
+            if (result == resultSuccess) { timer.cancel(); return transferred; }
+            if (result != resultInProgress) throw std::runtime_error("read failed");
+        }
+    }
+
+    // the previous SimpleSerial::readLine
+    std::string readLine() {
+        char c;
+        std::string line;
+        for (;;) {
+            boost::asio::read(port, boost::asio::buffer(&c, 1));
+            if (c == '\n') return line;
+            if (c != '\r') line += c;
+        }
+    }
+
+private:
+    boost::asio::io_context io;
+    boost::asio::serial_port port;
+    boost::asio::deadline_timer timer;
+    ReadResult result;
+    size_t transferred;
+};
+
+static double thread_cpu_seconds() {
+    struct rusage usage;
+    getrusage(RUSAGE_THREAD, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1e-6;
+}
+
+// runs reader against a pty fed with total_bytes of NMEA sentences
+template <typename Reader>
+static void measure(const char *label, Reader reader) {
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master < 0 || grantpt(master) || unlockpt(master)) throw std::runtime_error("cannot open a pseudo-terminal");
+    std::string slave = ptsname(master);
+
+    std::thread feeder([master]() {
+        std::string block;
+        while (block.size() < READ_CHUNK_SIZE) block += sentence;
+        for (size_t sent = 0; sent < total_bytes + block.size();) {
+            ssize_t n = write(master, block.data(), block.size());
+            if (n <= 0) break;
+            sent += (size_t)n;
+        }
+    });
+
+    double cpu = thread_cpu_seconds();
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    size_t bytes = reader(slave);
+    double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    cpu = thread_cpu_seconds() - cpu;
+
+    feeder.join();    // what is left unread fits in the pty buffer
+    close(master);
+    std::cout << label << bytes / wall / 1e6 << " MB/s, reader CPU " << 100. * cpu / wall << "%, " << cpu / bytes * 1e9 << " ns/byte" << std::endl;
+}
+
+int main() {
+    const size_t small = 4;   // what the decoders used to ask for
+
+    measure("legacy read(4)        ", [&](const std::string& device) {
+        LegacyDevice port(device);
+        char buffer[small];
+        size_t bytes = 0;
+        while (bytes < total_bytes) bytes += port.read(buffer, small);
+        return bytes;
+    });
+    measure("SerialDevice read(4)  ", [&](const std::string& device) {
+        SerialOptions options;
+        options.setDevice(device);
+        options.setBaudrate(115200);
+        options.setTimeout(boost::posix_time::seconds(SERIAL_PORT_TIMEOUT_SECONDS));
+        SerialDevice port(options);
+        char buffer[small];
+        size_t bytes = 0;
+        while (bytes < total_bytes) bytes += (size_t)port.read(buffer, small);
+        return bytes;
+    });
+    measure("legacy readLine       ", [&](const std::string& device) {
+        LegacyDevice port(device);
+        size_t bytes = 0;
+        while (bytes < total_bytes) bytes += port.readLine().size() + 2;
+        return bytes;
+    });
+    measure("SimpleSerial readLine ", [&](const std::string& device) {
+        SimpleSerial port(device, 115200);
+        size_t bytes = 0;
+        while (bytes < total_bytes) bytes += port.readLine().size() + 2;
+        return bytes;
+    });
+    return 0;
+}
+#else
+int main() {
+    std::cout << "This benchmark needs Linux pseudo-terminals" << std::endl;
+    return 0;
+}
+#endif
@@ -129,6 +129,14 @@ $TestExecutables = @{
     "Version Tests" = "test_version"
     "Constants Tests" = "test_constants"
     "Integration Tests" = "test_integration"
+    "Frame Decoder Tests" = "test_decoders"
+    "Checksum Tests" = "test_checksum"
+    "Number Parser Tests" = "test_number_tools"
+    "Output Writer Tests" = "test_output_tools"
+    "Sample Ring Tests" = "test_sample_ring"
+    "Shared Channel Tests" = "test_shared_channel"
+    "Multi-Port Reader Tests" = "test_port_reader"
+    "Pipelined Reader Tests" = "test_reader_pipeline"
 }
 
 # Alternative paths for different build configurations
@@ -0,0 +1,68 @@
+#include "checksum_tools.hpp"
+#include "test_fixtures.hpp"
+#include <cassert>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+int main() {
+    std::cout << "Testing checksum_tools functionality..." << std::endl;
+
+    // Test against the reference for every length and alignment up to a few blocks
+    {
+        std::vector<unsigned char> data(400);
+        srand(42);
+        for (size_t i = 0; i < data.size(); i++) data[i] = (unsigned char)(rand() & 0xFF);
+        for (size_t offset = 0; offset < 4; offset++) {
+            for (size_t len = 0; len + offset <= data.size(); len++) {
+                unsigned char a, b, ref_a, ref_b;
+                fletcher8(data.data() + offset, len, a, b);
+                reference_fletcher8(data.data() + offset, len, ref_a, ref_b);
+                assert(a == ref_a && b == ref_b);
+            }
+        }
+        std::cout << "✓ fletcher8 matches the byte-by-byte reference" << std::endl;
+    }
+
+    // Test saturated input, where the 32-bit accumulators wrap
+    {
+        std::vector<unsigned char> data(70000, 0xFF);
+        unsigned char a, b, ref_a, ref_b;
+        fletcher8(data.data(), data.size(), a, b);
+        reference_fletcher8(data.data(), data.size(), ref_a, ref_b);
+        assert(a == ref_a && b == ref_b);
+        std::cout << "✓ fletcher8 handles long saturated buffers" << std::endl;
+    }
+
+    // Test single frame validation
+    {
+        std::string frame = ubx_frame(0x01, 0x07, std::string(92, '\x5A'));
+        assert(ubx_frame_valid((const unsigned char*)frame.data()));
+        frame[50] ^= 0x01;
+        assert(!ubx_frame_valid((const unsigned char*)frame.data()));
+        std::string empty = ubx_frame(0x05, 0x01, "");
+        assert(ubx_frame_valid((const unsigned char*)empty.data()));
+        std::cout << "✓ UBX frame checksum validation works correctly" << std::endl;
+    }
+
+    // Test batch validation
+    {
+        std::string good = ubx_frame(0x01, 0x07, std::string(14, '\x01'));
+        std::string bad = good;
+        bad[bad.size() - 1] ^= 0xFF;
+        std::string stream = good + bad + good;
+        const unsigned char* frames[3] = {
+            (const unsigned char*)stream.data(),
+            (const unsigned char*)stream.data() + good.size(),
+            (const unsigned char*)stream.data() + 2 * good.size()
+        };
+        unsigned char valid[3];
+        assert(validate_ubx_frames(frames, 3, valid) == 2);
+        assert(valid[0] == 1 && valid[1] == 0 && valid[2] == 1);
+        std::cout << "✓ Batch validation flags corrupt frames" << std::endl;
+    }
+
+    std::cout << "All checksum tests passed!" << std::endl;
+    return 0;
+}
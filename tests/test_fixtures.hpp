@@ -0,0 +1,55 @@
+// Builders of the frames and records the tests feed to decoders and rings
+#pragma once
+
+#include "datalogger.h"
+#include <cstdio>
+#include <string>
+
+// Byte-by-byte Fletcher-8, as described in the UBX protocol specification
+inline void reference_fletcher8(const unsigned char* data, size_t len, unsigned char& ck_a, unsigned char& ck_b) {
+    ck_a = 0;
+    ck_b = 0;
+    for (size_t i = 0; i < len; i++) {
+        ck_a = (unsigned char)(ck_a + data[i]);
+        ck_b = (unsigned char)(ck_b + ck_a);
+    }
+}
+
+// UBX frame: sync, class, id, little endian length, payload and checksum
+inline std::string ubx_frame(unsigned char cls, unsigned char id, const std::string& payload) {
+    std::string frame("\xB5\x62", 2);
+    frame += (char)cls;
+    frame += (char)id;
+    uint16_t len = (uint16_t)payload.size();
+    frame.append((const char*)&len, sizeof(len));
+    frame += payload;
+    unsigned char ck_a, ck_b;
+    reference_fletcher8((const unsigned char*)frame.data() + 2, frame.size() - 2, ck_a, ck_b);
+    frame += (char)ck_a;
+    frame += (char)ck_b;
+    return frame;
+}
+
+// NMEA sentence: body between '$' and '*', followed by its checksum and CRLF
+inline std::string nmea_sentence(const std::string& body) {
+    unsigned char checksum = 0;
+    for (size_t i = 0; i < body.size(); i++) checksum ^= (unsigned char)body[i];
+    char hex[4];
+    snprintf(hex, sizeof(hex), "*%02X", checksum);
+    return "$" + body + hex + "\r\n";
+}
+
+// Record whose time and inertial values all carry index, to spot torn reads
+inline Record make_record(uint64_t index) {
+    Record record;
+    record.timestamp = (int64_t)index;
+    for (int i = 0; i < 6; i++) record.inertial[i] = (float)index;
+    record.valid = (1u << POS_TIME) | (1u << POS_AX);
+    return record;
+}
+
+inline bool consistent(const Record& record, uint64_t index) {
+    if (record.timestamp != (int64_t)index) return false;
+    for (int i = 0; i < 6; i++) if (record.inertial[i] != (float)index) return false;
+    return true;
+}
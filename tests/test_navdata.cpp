@@ -125,6 +125,107 @@ int main() {
     assert(zero_val[2] == 0.0);
     std::cout << "✓ Zero values work correctly" << std::endl;
 
+    // Test presence of fields and text produced on demand
+    {
+        NavData fresh;
+        assert(!fresh.isSet(POS_AX));
+        assert(fresh.getAcc_s()[0].empty());
+        assert(fresh.to_string() == ";;;;;;;;;;;;;");
+        fresh.setLat(44.49);
+        assert(fresh.isSet(POS_LAT));
+        assert(!fresh.isSet(POS_LON));
+        assert(fresh.getLat_s() == "44.49");
+        std::string fields[3] = {"0.0123", "bad", "-9.81"};
+        fresh.setAcc_s(fields);
+        assert(fresh.isSet(POS_AX) && !fresh.isSet(POS_AY) && fresh.isSet(POS_AZ));
+        assert(fresh.getAcc_s()[0] == "0.0123");
+        float single[3] = {10.1f, 0.123f, -1.5f};
+        fresh.setGyr(single);
+        assert(fresh.getGyr_s()[0] == "10.1");
+        assert(fresh.getGyr_s()[1] == "0.123");
+        std::cout << "✓ Fields are tracked as set and formatted on demand" << std::endl;
+    }
+
+    // Test record formatting into a caller buffer
+    {
+        NavData record;
+        record.setTime_s("2015:6:15:12:0:0");
+        double acc[3] = {0.1, -9.81, 1.0 / 3.0};
+        record.setAcc(acc);
+        record.setLat(44.491234567);
+        char buffer[RECORD_MAX_SIZE];
+        std::string line(buffer, record.format(buffer, sizeof(buffer), RecordSchema::defaults()));
+        assert(line == "2015:6:15:12:0:0;0.1;-9.81;0.3333333333333333;;;;44.491234567;;;;;;");
+        assert(line == record.to_string());
+        line.assign(buffer, record.format(buffer, sizeof(buffer), RecordSchema::rounded()));
+        assert(line == "2015:6:15:12:0:0;0.1;-9.81;0.333333;;;;44.49123457;;;;;;");
+        assert(record.format(buffer, 40, RecordSchema::rounded()) == 0);
+        std::cout << "✓ Records format into a caller buffer following the schema" << std::endl;
+    }
+
+    // Test numeric timestamps and the cached date prefix
+    {
+        TimeFormatter time_format;
+        char buffer[2 * NUMBER_FORMAT_MAX];
+        for (time_t t = 1434369590; t < 1434369730; t += 7) {
+            struct tm * now = gmtime(&t);
+            std::stringstream expected;
+            expected << now->tm_year + 1900 << ':' << now->tm_mon + 1 << ':' << now->tm_mday << ':'
+                     << now->tm_hour << ':' << now->tm_min << ':' << now->tm_sec;
+            assert(std::string(buffer, time_format.format(buffer, (int64_t)t * 1000000000, 0)) == expected.str());
+        }
+        std::string line(buffer, time_format.format(buffer, (int64_t)1434369600 * 1000000000 + 120000000, 3));
+        assert(line.substr(line.size() - 6) == ":0.120");
+        line.assign(buffer, time_format.format(buffer, (int64_t)1434369599 * 1000000000 + 999600000, 3));
+        assert(line.substr(line.size() - 6) == ":0.000"); // rounds into the next minute
+        line.assign(buffer, time_format.format(buffer, (int64_t)1434369600 * 1000000000 - 100000000, 1));
+        assert(line.substr(line.size() - 5) == ":59.9");
+
+        NavData record;
+        record.setTime((time_t)1434369600);
+        assert(record.isSet(POS_TIME) && record.getTimestamp() == (int64_t)1434369600 * 1000000000);
+        assert(record.to_string().find(std::string(buffer, time_format.format(buffer, record.getTimestamp(), 0)) + ";") == 0);
+        record.setTime_s("utc");
+        assert(record.getTimestamp() == 0 && record.getTime() == "utc");
+
+        static_assert(utc_nanoseconds(2015, 6, 15, 12, 0, 0, 120000000) == INT64_C(1434369600120000000), "utc_nanoseconds");
+        for (int64_t days = -800000; days < 800000; days += 997) {
+            int64_t year;
+            unsigned int month, day;
+            civil_from_days(days, year, month, day);
+            assert(days_from_civil(year, month, day) == days);
+        }
+        assert(days_from_civil(2016, 3, 1) - days_from_civil(2016, 2, 28) == 2);
+        assert(days_from_civil(2100, 3, 1) - days_from_civil(2100, 2, 28) == 1);
+        std::cout << "✓ Timestamps are stored as UTC nanoseconds and formatted with a cached prefix" << std::endl;
+    }
+
+    // Test conversion to the record shared through the rings
+    {
+        NavData nav;
+        nav.setTimestamp(INT64_C(1500000000123000000), 3);
+        double acc[3] = {0.5, -1.25, 9.81};
+        nav.setAcc(acc);
+        nav.setLat(44.4949123);
+        nav.setLon(-11.3426987);
+        nav.setHead(-90.);
+        nav.setHDOP(1.27);
+        nav.setQlt(3.);
+        Record record = nav.toRecord();
+        assert(record.timestamp == INT64_C(1500000000123000000));
+        assert(record.lat == 444949123 && record.lon == -113426987);
+        assert(record.heading == 27000 && record.hdop == 127 && record.quality == 3);
+        assert(record.inertial[2] == 9.81f && record.isSet(POS_AZ) && !record.isSet(POS_GX) && !record.isSet(POS_SPEED));
+
+        NavData copy;
+        copy.setRecord(record);
+        assert(copy.getTimestamp() == nav.getTimestamp());
+        assert(copy.isSet(POS_LAT) && !copy.isSet(POS_ALT));
+        assert(std::fabs(copy.getLat() - 44.4949123) < 1e-9 && copy.getHead() == 270.);
+        assert(copy.getAcc_s()[2] == "9.81");
+        std::cout << "✓ Samples convert to and from shared ring records" << std::endl;
+    }
+
     std::cout << "All NavData tests passed!" << std::endl;
     return 0;
 }
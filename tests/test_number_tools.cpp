@@ -0,0 +1,133 @@
+#include "number_tools.h"
+#include <cassert>
+#include <clocale>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+static NumberStatus decimal(const std::string& text, double& value) {
+    return parse_decimal(text.data(), text.data() + text.size(), value);
+}
+
+int main() {
+    std::cout << "Testing number_tools functionality..." << std::endl;
+
+    // Test integers
+    {
+        int64_t value = 0;
+        std::string text = " -12345 ";
+        assert(parse_integer(text.data(), text.data() + text.size(), value) == numberOk && value == -12345);
+        text = "+7";
+        assert(parse_integer(text.data(), text.data() + text.size(), value) == numberOk && value == 7);
+        text = "-9223372036854775808";
+        assert(parse_integer(text.data(), text.data() + text.size(), value) == numberOk && value == INT64_MIN);
+        text = "9223372036854775808";
+        assert(parse_integer(text.data(), text.data() + text.size(), value) == numberOutOfRange);
+        text = "12a";
+        assert(parse_integer(text.data(), text.data() + text.size(), value) == numberInvalid);
+        text = "  ";
+        assert(parse_integer(text.data(), text.data() + text.size(), value) == numberEmpty);
+        std::cout << "✓ Integers parse with range and syntax checks" << std::endl;
+    }
+
+    // Test decimals in the formats found in the logs
+    {
+        double value = 0;
+        assert(decimal("0.1", value) == numberOk && value == 0.1);
+        assert(decimal("-9.81", value) == numberOk && value == -9.81);
+        assert(decimal("4429.4000", value) == numberOk && value == 4429.4);
+        assert(decimal("+00120", value) == numberOk && value == 120.0);
+        assert(decimal(".5", value) == numberOk && value == 0.5);
+        assert(decimal("5.", value) == numberOk && value == 5.0);
+        assert(decimal("1.0000000000000001e-05", value) == numberOk && value == 1.0000000000000001e-05);
+        assert(decimal("-0", value) == numberOk && value == 0.0 && std::signbit(value));
+        assert(decimal("1e400", value) == numberOutOfRange);
+        assert(decimal("", value) == numberEmpty);
+        assert(decimal("-", value) == numberInvalid);
+        assert(decimal(".", value) == numberInvalid);
+        assert(decimal("1,5", value) == numberInvalid);
+        assert(decimal("1e", value) == numberInvalid);
+        assert(decimal("nan", value) == numberInvalid);
+        std::cout << "✓ Decimals parse with syntax checks" << std::endl;
+    }
+
+    // Test agreement with strtod on random values
+    {
+        srand(7);
+        char text[64];
+        for (int i = 0; i < 200000; i++) {
+            double original = (rand() - RAND_MAX / 2) / (double)(1 + rand() % 100000);
+            int precision = 1 + rand() % 17;
+            if (i % 2) snprintf(text, sizeof(text), "%.*f", precision % 10, original);
+            else snprintf(text, sizeof(text), "%.*g", precision, original * pow(10., rand() % 40 - 20));
+            double expected = strtod(text, NULL);
+            double value;
+            assert(decimal(text, value) == numberOk);
+            assert(value == expected || std::fabs(value - expected) <= std::fabs(expected) * 1e-15);
+        }
+        std::cout << "✓ Decimals agree with strtod" << std::endl;
+    }
+
+    // Test lenient conversion
+    {
+        assert(decimal_or_zero("12.5") == 12.5);
+        assert(decimal_or_zero("") == 0.0);
+        assert(decimal_or_zero("x") == 0.0);
+        std::cout << "✓ decimal_or_zero falls back to zero" << std::endl;
+    }
+
+    // Test fixed formatting with trailing zeros removed
+    {
+        char out[NUMBER_FORMAT_MAX];
+        assert(std::string(out, format_fixed(out, 1.5, 6)) == "1.5");
+        assert(std::string(out, format_fixed(out, 2.0, 6)) == "2");
+        assert(std::string(out, format_fixed(out, -0.0123, 6)) == "-0.0123");
+        assert(std::string(out, format_fixed(out, 44.49123456789, 8)) == "44.49123457");
+        assert(std::string(out, format_fixed(out, -0.0000001, 6)) == "0");
+        assert(std::string(out, format_fixed(out, 0.9999996, 6)) == "1");
+        assert(std::string(out, format_fixed(out, 3.0, 0)) == "3");
+        assert(std::string(out, format_fixed(out, 1e300, 2)).size() == NUMBER_FORMAT_MAX);
+        std::cout << "✓ Fixed formatting rounds and trims correctly" << std::endl;
+    }
+
+    // Test shortest round-trip formatting
+    {
+        char out[NUMBER_FORMAT_MAX];
+        assert(std::string(out, format_shortest(out, 0.1)) == "0.1");
+        assert(std::string(out, format_shortest(out, 10.1f)) == "10.1");
+        srand(11);
+        for (int i = 0; i < 100000; i++) {
+            double original = (rand() - RAND_MAX / 2) / (double)(1 + rand());
+            double check;
+            size_t len = format_shortest(out, original);
+            assert(parse_decimal(out, out + len, check) == numberOk && check == original);
+            float single = (float)original;
+            len = format_shortest(out, single);
+            assert(parse_decimal(out, out + len, check) == numberOk && (float)check == single);
+        }
+        std::cout << "✓ Shortest formatting reads back to the same value" << std::endl;
+    }
+
+    // Test shortest formatting ignores a locale with a decimal comma
+    {
+        const char* names[] = { "de_DE.UTF-8", "it_IT.UTF-8", "fr_FR.UTF-8", "de_DE", "German" };
+        std::string previous = setlocale(LC_NUMERIC, NULL);
+        bool comma = false;
+        for (size_t i = 0; i < sizeof(names) / sizeof(names[0]) && !comma; i++) comma = setlocale(LC_NUMERIC, names[i]) != NULL;
+        if (comma) {
+            char out[NUMBER_FORMAT_MAX];
+            assert(std::string(out, format_shortest(out, 44.491234567)) == "44.491234567");
+            assert(std::string(out, format_shortest(out, 1.0 / 3.0)) == "0.3333333333333333");
+            assert(std::string(out, format_shortest(out, -1.5e-7f)) == "-1.5e-07");
+            setlocale(LC_NUMERIC, previous.c_str());
+            std::cout << "✓ Shortest formatting writes '.' whatever the locale" << std::endl;
+        }
+        else std::cout << "✓ Locale independence skipped (no decimal comma locale installed)" << std::endl;
+    }
+
+    std::cout << "All number parser tests passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,100 @@
+#include "output_tools.h"
+#include <cassert>
+#include <csignal>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+static void write_line(RecordWriter& writer, const std::string& text) {
+    writer.write(text.data(), text.size());
+}
+
+int main() {
+    std::cout << "Testing output_tools functionality..." << std::endl;
+
+    // Test flush by record count
+    {
+        std::ostringstream out;
+        RecordWriter writer(out, FlushPolicy(3, 0));
+        write_line(writer, "a");
+        write_line(writer, "b");
+        assert(out.str().empty() && writer.pending() == 2);
+        write_line(writer, "c");
+        assert(out.str() == "a\nb\nc\n" && writer.pending() == 0);
+        std::cout << "✓ Records are flushed every N lines" << std::endl;
+    }
+
+    // Test flush by age of the oldest record
+    {
+        std::ostringstream out;
+        RecordWriter writer(out, FlushPolicy(0, 20));
+        write_line(writer, "first");
+        writer.poll();
+        assert(out.str().empty());
+        std::this_thread::sleep_for(std::chrono::milliseconds(30));
+        writer.poll();
+        assert(out.str() == "first\n" && writer.pending() == 0);
+        std::cout << "✓ Records are flushed after T milliseconds" << std::endl;
+    }
+
+    // Test nothing is lost on destruction
+    {
+        std::ostringstream out;
+        {
+            RecordWriter writer(out, FlushPolicy(0, 0));
+            write_line(writer, "1;2;3");
+            write_line(writer, "4;5;6");
+            assert(out.str().empty());
+        }
+        assert(out.str() == "1;2;3\n4;5;6\n");
+        std::cout << "✓ Pending records are written by the destructor" << std::endl;
+    }
+
+    // Test small buffers and oversized records keep the order
+    {
+        std::ostringstream out;
+        RecordWriter writer(out, FlushPolicy(0, 0), 8);
+        write_line(writer, "abc");
+        write_line(writer, "def");
+        write_line(writer, "0123456789");
+        write_line(writer, "gh");
+        writer.flush();
+        assert(out.str() == "abc\ndef\n0123456789\ngh\n");
+        std::cout << "✓ Buffer overflow writes records in order" << std::endl;
+    }
+
+    // Test the flush policy restarts after the buffer is handed to the stream
+    {
+        std::ostringstream out;
+        RecordWriter writer(out, FlushPolicy(2, 200), 8);
+        write_line(writer, "abc");
+        std::this_thread::sleep_for(std::chrono::milliseconds(150));
+        write_line(writer, "defgh");
+        assert(out.str() == "abc\n" && writer.pending() == 1);
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        writer.poll();
+        assert(out.str() == "abc\n" && writer.pending() == 1);
+
+        write_line(writer, "0123456789");
+        assert(out.str() == "abc\ndefgh\n0123456789\n" && writer.pending() == 0);
+        writer.poll();
+        write_line(writer, "ij");
+        writer.poll();
+        assert(writer.pending() == 1);
+        assert(out.str() == "abc\ndefgh\n0123456789\n");
+        std::cout << "✓ Spilling the buffer resets the flush policy counters" << std::endl;
+    }
+
+    // Test shutdown signals are caught
+    {
+        install_shutdown_handler();
+        assert(!shutdown_requested());
+        std::raise(SIGINT);
+        assert(shutdown_requested());
+        std::cout << "✓ SIGINT requests a shutdown instead of terminating" << std::endl;
+    }
+
+    std::cout << "All output_tools tests passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,126 @@
+#include "port_reader.hpp"
+#include "test_fixtures.hpp"
+#include <cassert>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__)
+// Run the ready handlers until the condition holds, for at most a couple of seconds
+template<typename Condition> static bool run_until(boost::asio::io_context& io, Condition done) {
+    for (int i = 0; i < 200 && !done(); i++) {
+        io.restart();
+        io.poll();
+        usleep(10000);
+    }
+    return done();
+}
+
+static int open_master(std::string& device) {
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+    assert(master >= 0 && grantpt(master) == 0 && unlockpt(master) == 0);
+    device = ptsname(master);
+    return master;
+}
+#endif
+
+int main() {
+    std::cout << "Testing multi-port acquisition..." << std::endl;
+
+    // Test port specifications as given to serial_reader -m
+    {
+        size_t box_count = get_box_types().size();
+        PortSpec spec;
+        assert(parse_port_spec("/dev/ttyUSB0:115200:8", box_count, spec));
+        assert(spec.port == "/dev/ttyUSB0" && spec.baudrate == 115200 && spec.box_type == 8);
+        assert(parse_port_spec("\\\\.\\COM10:9600:1", box_count, spec));
+        assert(spec.port == "\\\\.\\COM10" && spec.baudrate == 9600 && spec.box_type == 1);
+        assert(parse_port_spec("odd:name:4800:10", box_count, spec));
+        assert(spec.port == "odd:name" && spec.box_type == 10);
+
+        assert(!parse_port_spec("COM3:9600", box_count, spec));
+        assert(!parse_port_spec(":9600:5", box_count, spec));
+        assert(!parse_port_spec("COM3::5", box_count, spec));
+        assert(!parse_port_spec("COM3:fast:5", box_count, spec));
+        assert(!parse_port_spec("COM3:0:5", box_count, spec));
+        assert(!parse_port_spec("COM3:99999999999:5", box_count, spec));
+        assert(!parse_port_spec("COM3:9600:0", box_count, spec));
+        assert(!parse_port_spec("COM3:9600:11", box_count, spec));
+        std::cout << "✓ Port specifications are parsed and validated" << std::endl;
+    }
+
+#if defined(__linux__)
+    // Test two boxes served by one io_context, a failing port leaving the other running
+    {
+        std::string nmea_device, ubx_device;
+        int nmea_master = open_master(nmea_device);
+        int ubx_master = open_master(ubx_device);
+
+        PortSpec nmea_spec = { nmea_device, 115200, 8 };
+        PortSpec ubx_spec = { ubx_device, 115200, 6 };
+        boost::asio::io_context io;
+        SerialOptions tuning;
+        tuning.setReadChunkSize(16);
+        PortReader nmea(io, nmea_spec, RingOptions(64), tuning);
+        PortReader ubx(io, ubx_spec, RingOptions(64), tuning);
+        assert(nmea.boxName() == "NMEA" && ubx.boxName() == "UBX");
+        nmea.start();
+        ubx.start();
+
+        std::string fix = nmea_sentence("GPGGA,120000.00,4429.4000,N,01121.0000,E,1,08,0.9,54.0,M,46.9,M,,")
+                        + nmea_sentence("GPRMC,120000.00,A,4429.4000,N,01121.0000,E,10.0,45.0,150615,,,A");
+        assert(write(nmea_master, fix.data(), fix.size()) == (ssize_t)fix.size());
+        assert(run_until(io, [&]() { return nmea.frameDecoder().framesAccepted() == 2; }));
+        assert(nmea.isOpen() && ubx.isOpen());
+        std::cout << "✓ Frames arriving on one port are decoded by its own reader" << std::endl;
+
+        close(ubx_master);
+        assert(run_until(io, [&]() { return !ubx.isOpen(); }));
+        assert(nmea.isOpen());
+        assert(write(nmea_master, fix.data(), fix.size()) == (ssize_t)fix.size());
+        assert(run_until(io, [&]() { return nmea.frameDecoder().framesAccepted() == 4; }));
+        std::cout << "✓ A failing port is closed while the others keep reading" << std::endl;
+
+        nmea.close();
+        io.restart();
+        io.run();
+        nmea.flush();
+        ubx.flush();
+        std::ifstream log("NMEA.log");
+        std::string line;
+        size_t lines = 0;
+        while (std::getline(log, line)) lines++;
+        assert(lines == 2);
+        std::cout << "✓ Each box is logged to its own file" << std::endl;
+
+        close(nmea_master);
+        remove("NMEA.log");
+        remove("UBX.log");
+    }
+
+    // Test a log file that cannot be opened stops the reader from starting
+    {
+        std::string device;
+        int master = open_master(device);
+        assert(mkdir("NMEA.log", 0755) == 0);   // a directory in the way of the log
+        PortSpec spec = { device, 115200, 8 };
+        boost::asio::io_context io;
+        bool thrown = false;
+        try { PortReader reader(io, spec, RingOptions(64), SerialOptions()); }
+        catch (std::runtime_error& e) { thrown = std::string(e.what()).find("NMEA.log") != std::string::npos; }
+        assert(thrown);
+        rmdir("NMEA.log");
+        close(master);
+        std::cout << "✓ An unwritable log file is reported instead of dropping the records" << std::endl;
+    }
+#endif
+
+    std::cout << "All multi-port acquisition tests passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,115 @@
+#include "reader_pipeline.hpp"
+#include "test_fixtures.hpp"
+#include <cassert>
+#include <cstdio>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+// Holds the decode stage until opened, to fill the queue in front of it
+class GatedDecoder : public NmeaDecoder {
+public:
+    std::atomic<bool> open;
+    GatedDecoder() : open(false) {}
+    size_t feed(const char *data, size_t len, SampleBatch& out) {
+        while (!open.load()) boost::this_thread::sleep(boost::posix_time::milliseconds(1));
+        return NmeaDecoder::feed(data, len, out);
+    }
+};
+
+int main() {
+    std::cout << "Testing the pipelined reader..." << std::endl;
+
+    std::string stream;
+    for (int i = 0; i < 50; i++) {
+        char time[16];
+        snprintf(time, sizeof(time), "1200%02d.00", i);
+        stream += nmea_sentence(std::string("GPGGA,") + time + ",4429.4000,N,01121.0000,E,1,08,0.9,54.0,M,46.9,M,,");
+        stream += nmea_sentence(std::string("GPRMC,") + time + ",A,4429.4000,N,01121.0000,E,10.0,45.0,150615,,,A");
+    }
+
+    // Test an idle stage sleeps until notified instead of polling
+    {
+        StageSignal signal;
+        std::atomic<bool> pushed(false);
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        signal.wait([&]() { return pushed.load(); }, 50);
+        assert(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(40));
+
+        std::chrono::steady_clock::time_point woken;
+        boost::thread consumer([&]() {
+            while (!pushed.load()) signal.wait([&]() { return pushed.load(); }, 10000);
+            woken = std::chrono::steady_clock::now();
+        });
+        boost::this_thread::sleep(boost::posix_time::milliseconds(50));
+        std::chrono::steady_clock::time_point notified = std::chrono::steady_clock::now();
+        pushed.store(true);
+        signal.notify();
+        consumer.join();
+        assert(woken - notified < std::chrono::seconds(1));
+        std::cout << "✓ An idle stage sleeps until the stage before it notifies" << std::endl;
+    }
+
+    // Test that the pipeline writes exactly what decoding in place writes
+    {
+        std::ostringstream direct_out;
+        {
+            NmeaDecoder decoder;
+            SampleSink sink(direct_out, "PipelineTestDirect", RingOptions(64));
+            SampleBatch batch;
+            decoder.feed(stream.data(), stream.size(), batch);
+            sink.write(batch, decoder.hasOwnTime());
+            sink.flush();
+        }
+
+        std::ostringstream piped_out;
+        NmeaDecoder decoder;
+        SampleSink sink(piped_out, "PipelineTestPiped", RingOptions(64));
+        ReaderPipeline pipeline(decoder, sink, 4096);
+        for (size_t pos = 0; pos < stream.size(); pos += 7) assert(pipeline.push(stream.data() + pos, std::min<size_t>(7, stream.size() - pos)));
+        pipeline.stop();
+        sink.flush();
+
+        assert(decoder.framesAccepted() == 100);
+        assert(pipeline.chunksRead() == (stream.size() + 6) / 7);
+        assert(pipeline.bytesDropped() == 0);
+        assert(!direct_out.str().empty());
+        assert(piped_out.str() == direct_out.str());
+        std::cout << "✓ Chunks are decoded and written in order by the later stages" << std::endl;
+
+        std::ostringstream report;
+        pipeline.report(report);
+        assert(report.str().find("Decode queue: mean ") == 0);
+        assert(report.str().find("of 4096 chunks") != std::string::npos);
+        assert(report.str().find("of 4096 batches") != std::string::npos);
+        assert(report.str().find("Dropped") == std::string::npos);
+        std::cout << "✓ Queue occupancy is reported per stage" << std::endl;
+    }
+
+    // Test that a stalled decode stage makes the reader drop bytes instead of waiting
+    {
+        std::ostringstream out;
+        GatedDecoder decoder;
+        SampleSink sink(out, "PipelineTestGated", RingOptions(64));
+        const size_t depth = 4;
+        ReaderPipeline pipeline(decoder, sink, depth);
+        size_t accepted = 0, refused = 0;
+        for (size_t i = 0; i < 2 * depth + 2; i++) {
+            if (pipeline.push(stream.data(), 10)) accepted++;
+            else refused++;
+        }
+        // the decode stage may hold one chunk on top of a full queue
+        assert(accepted >= depth && accepted <= depth + 1);
+        assert(pipeline.bytesDropped() == 10 * refused);
+
+        decoder.open.store(true);
+        pipeline.stop();
+        std::ostringstream report;
+        pipeline.report(report);
+        assert(report.str().find("Dropped " + std::to_string(10 * refused) + " bytes") != std::string::npos);
+        std::cout << "✓ A full decode stage never blocks the reader" << std::endl;
+    }
+
+    std::cout << "All pipelined reader tests passed!" << std::endl;
+    return 0;
+}
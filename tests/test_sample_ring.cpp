@@ -0,0 +1,165 @@
+#include "sample_ring.h"
+#include "datalogger.h"
+#include "test_fixtures.hpp"
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+// ring memory with the alignment of a shared memory mapping
+alignas(CACHE_LINE_SIZE) static unsigned char memory[64 * 1024];
+
+int main() {
+    std::cout << "Testing sample ring functionality..." << std::endl;
+
+    // Test records become visible only when published
+    {
+        assert(SampleRing::bytes(8) <= sizeof(memory));
+        SampleRing ring = SampleRing::create(memory, 8);
+        assert(ring.valid() && ring.capacity() == 8 && ring.head() == 0);
+        Record record;
+        ring.push(make_record(0));
+        ring.push(make_record(1));
+        assert(ring.head() == 0 && !ring.read(0, record));
+        assert(ring.publish() == 2);
+        assert(ring.read(1, record) && consistent(record, 1));
+        assert(!ring.read(2, record));
+        std::cout << "✓ A batch of records is published with one store" << std::endl;
+    }
+
+    // Test readers attached later see the same ring and detect overwritten records
+    {
+        assert(SampleRing::bytes(4) <= sizeof(memory));
+        SampleRing producer = SampleRing::create(memory, 4);
+        SampleRing reader = SampleRing::attach(memory);
+        for (uint64_t i = 0; i < 10; i++) producer.push(make_record(i));
+        producer.publish();
+        Record record;
+        assert(reader.head() == 10);
+        assert(!reader.read(5, record));
+        assert(reader.read(6, record) && consistent(record, 6));
+
+        Record window[8];
+        uint64_t first;
+        assert(reader.readLatest(window, 8, first) == 4 && first == 6);
+        assert(consistent(window[0], 6) && consistent(window[3], 9));
+        assert(reader.readLatest(window, 2, first) == 2 && first == 8);
+
+        SampleRing resumed = SampleRing::attach(memory);
+        resumed.push(make_record(10));
+        assert(resumed.publish() == 11);
+        assert(reader.read(10, record) && consistent(record, 10));
+        std::cout << "✓ Lapped records are reported instead of returned torn" << std::endl;
+    }
+
+    // Test memory that does not hold a ring of this layout is refused
+    {
+        SampleRing ring = SampleRing::create(memory, 4, 100., "Octo");
+        assert(ring.boxName() == "Octo" && ring.sampleRate() == 100.);
+        bool refused = false;
+        try { SampleRing::attach(memory, SampleRing::bytes(3)); } catch (std::runtime_error&) { refused = true; }
+        assert(refused);
+        reinterpret_cast<SampleRingHeader*>(memory)->version = SAMPLE_RING_VERSION + 1;
+        refused = false;
+        try { SampleRing::attach(memory); } catch (std::runtime_error&) { refused = true; }
+        assert(refused);
+        std::cout << "✓ Incompatible or truncated rings are refused" << std::endl;
+    }
+
+    // Test compact rings hold half-size records and are not mistaken for full ones
+    {
+        assert(CompactSampleRing::bytes(64) * 2 == SampleRing::bytes(64) + sizeof(SampleRingHeader));
+        CompactSampleRing ring = CompactSampleRing::create(memory, 64);
+        Record full = make_record(5);
+        full.timestamp = INT64_C(1500000000123456789);
+        ring.push(CompactRecord(full));
+        ring.publish();
+        CompactRecord record;
+        assert(CompactSampleRing::attach(memory).read(0, record));
+        assert(record.milliseconds == (uint32_t)(INT64_C(1500000000123)) && record.inertial[5] == 5.f);
+        Record expanded = record.expand();
+        assert(expanded.isSet(POS_AZ) && !expanded.isSet(POS_TIME) && !expanded.isSet(POS_LAT) && expanded.inertial[2] == 5.f);
+        assert(sample_ring_layout(memory) == RECORD_LAYOUT_COMPACT);
+        bool refused = false;
+        try { SampleRing::attach(memory); } catch (std::runtime_error&) { refused = true; }
+        assert(refused);
+        std::cout << "✓ Compact rings carry inertial records in half a cache line" << std::endl;
+    }
+
+    // Test concurrent readers never see torn records
+    {
+        const uint64_t total = 200000;
+        assert(SampleRing::bytes(16) <= sizeof(memory));
+        SampleRing ring = SampleRing::create(memory, 16);
+        std::vector<std::thread> readers;
+        std::vector<size_t> seen(3, 0);
+        for (size_t r = 0; r < seen.size(); r++) {
+            readers.push_back(std::thread([&ring, &seen, r, total]() {
+                SampleRing view = ring;
+                Record window[16];
+                uint64_t first;
+                while (view.head() < total) {
+                    size_t n = view.readLatest(window, 16, first);
+                    for (size_t k = 0; k < n; k++) assert(consistent(window[k], first + k));
+                    seen[r] += n;
+                }
+            }));
+        }
+        for (uint64_t i = 0; i < total; i++) {
+            ring.push(make_record(i));
+            if (i % 5 == 4) ring.publish();
+        }
+        ring.publish();
+        for (auto& reader : readers) reader.join();
+        std::cout << "✓ Concurrent readers get consistent snapshots" << std::endl;
+    }
+
+    // Test consumers sleep until the producer publishes
+    {
+        SampleRing ring = SampleRing::create(memory, 16);
+        SampleRingHeader* header = reinterpret_cast<SampleRingHeader*>(memory);
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        assert(!ring.wait(0, 20));
+        assert(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(20));
+        assert(header->waiters.load() == 0);
+
+        std::vector<std::thread> sleepers;
+        std::atomic<int> woken(0);
+        for (int r = 0; r < 3; r++) {
+            sleepers.push_back(std::thread([&ring, &woken]() {
+                SampleRing view = ring;
+                if (view.wait(0, 10000)) woken++;
+            }));
+        }
+        while (header->waiters.load() < 3) std::this_thread::yield();
+        start = std::chrono::steady_clock::now();
+        ring.push(make_record(0));
+        ring.publish();
+        for (auto& sleeper : sleepers) sleeper.join();
+        assert(woken == 3 && header->waiters.load() == 0);
+        assert(std::chrono::steady_clock::now() - start < std::chrono::seconds(1));
+        assert(ring.wait(0, 0) && !ring.wait(1, 0));
+        std::cout << "✓ Waiting consumers are woken by publish" << std::endl;
+    }
+
+#if defined(USE_HOST_MEMORY)
+    // Test the ring in a shared memory segment
+    {
+        const char* name = "testring";
+        void* created = allocate_host_memory(name, SampleRing::bytes(DIMENSIONE_MAX));
+        SampleRing producer = SampleRing::create(created, DIMENSIONE_MAX);
+        SampleRing reader = SampleRing::attach(get_host_allocated_memory(name));
+        producer.push(make_record(41));
+        producer.publish();
+        Record record;
+        assert(reader.capacity() == DIMENSIONE_MAX && reader.read(0, record) && consistent(record, 41));
+        remove_host_memory(name);
+        std::cout << "✓ Ring works across mappings of a shared memory segment" << std::endl;
+    }
+#endif
+
+    std::cout << "All sample ring tests passed!" << std::endl;
+    return 0;
+}
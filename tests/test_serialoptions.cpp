@@ -1,6 +1,10 @@
 #include "serial_tools.h"
 #include <cassert>
 #include <iostream>
+#if defined(__linux__)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 int main(){
     std::cout << "Testing SerialOptions class..." << std::endl;
@@ -92,6 +96,39 @@ int main(){
     assert(opt2.getTimeout() == opt.getTimeout());
     std::cout << "✓ Copy constructor works correctly" << std::endl;
 
+    // Test Linux tuning options, off by default
+    {
+        SerialOptions tuned;
+        assert(!tuned.getLowLatency() && tuned.getReadChunkSize() == READ_CHUNK_SIZE);
+        tuned.setLowLatency(true);
+        tuned.setReadChunkSize(256);
+        assert(tuned.getLowLatency() && tuned.getReadChunkSize() == 256);
+        tuned.setReadChunkSize(0);
+        assert(tuned.getReadChunkSize() == 1);
+        SerialOptions copy(tuned);
+        assert(copy.getLowLatency() && copy.getReadChunkSize() == 1);
+        std::cout << "✓ Low latency and read chunk options set/get correctly" << std::endl;
+    }
+
+#if defined(__linux__)
+    // Test options a device refuses are skipped with a warning: a pseudo-terminal has no serial_struct
+    {
+        int master = posix_openpt(O_RDWR | O_NOCTTY);
+        assert(master >= 0 && grantpt(master) == 0 && unlockpt(master) == 0);
+        SerialOptions tuned;
+        tuned.setDevice(ptsname(master));
+        tuned.setTimeout(boost::posix_time::seconds(1));
+        tuned.setLowLatency(true);
+        tuned.setReadChunkSize(8);
+        SerialDevice port(tuned);
+        assert(write(master, "abcd", 4) == 4);
+        char data[4];
+        assert(port.read(data, sizeof(data)) == 4 && memcmp(data, "abcd", 4) == 0);
+        close(master);
+        std::cout << "✓ Refused tuning options fall back to the driver defaults" << std::endl;
+    }
+#endif
+
     std::cout << "All SerialOptions tests passed!" << std::endl;
     return 0;
 }
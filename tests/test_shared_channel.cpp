@@ -0,0 +1,139 @@
+#include "shared_channel.h"
+#include "datalogger.h"
+#include "test_fixtures.hpp"
+#include <cassert>
+#include <cmath>
+#include <iostream>
+
+int main() {
+    std::cout << "Testing shared channel functionality..." << std::endl;
+
+#if defined(USE_HOST_MEMORY)
+    // Test segments describe themselves and can be opened in any order
+    {
+        const char* name = "testchannel_open";
+        remove_host_memory(name);
+        SharedChannel reader(name, RingOptions::window(60., 400.));
+        assert(reader.isOpen() && reader.name() == name);
+        assert(reader.ring().capacity() == 24000 && reader.ring().sampleRate() == 400. && reader.ring().boxName() == name);
+        SharedChannel producer(name, RingOptions(10));
+        assert(producer.ring().capacity() == 24000);
+        producer.ring().push(make_record(7));
+        producer.ring().publish();
+        Record record;
+        assert(reader.ring().read(0, record) && consistent(record, 7));
+
+        SharedChannel(name).ring().push(make_record(8));   // a new producer resumes from the head
+        SharedChannel resumed(name);
+        resumed.ring().push(make_record(1));
+        assert(resumed.ring().publish() == 2);
+        remove_host_memory(name);
+
+        const char* big = "testchannel_huge";
+        remove_host_memory(big);
+        RingOptions huge(100000, 0., true);
+        assert(huge.segmentSize() % HUGE_PAGE_SIZE == 0 && huge.segmentSize() >= SampleRing::bytes(100000));
+        SharedChannel large(big, huge);
+        for (uint64_t i = 0; i < 100000; i++) large.ring().push(make_record(i));
+        large.ring().publish();
+        assert(SharedChannel(big).ring().read(99999, record) && consistent(record, 99999));
+        remove_host_memory(big);
+        std::cout << "✓ Segments carry their layout and open in any order" << std::endl;
+    }
+
+#if !defined(_WIN32)
+    // Test attaching between the creation of a segment and its sizing
+    {
+        const char* name = "testchannel_unsized";
+        remove_host_memory(name);
+        RingOptions options(64);
+        boost::interprocess::shared_memory_object shm(boost::interprocess::create_only, name, boost::interprocess::read_write);
+        boost::thread creator([&]() {
+            boost::this_thread::sleep(boost::posix_time::milliseconds(50));
+            shm.truncate(options.segmentSize());
+            boost::interprocess::mapped_region region(shm, boost::interprocess::read_write);
+            SampleRing::create(region.get_address(), options.capacity, options.sample_rate, name);
+        });
+        SharedChannel reader(name, options);
+        creator.join();
+        assert(reader.isOpen() && reader.capacity() == 64);
+        assert(SharedChannel::mappings() == 1);
+        remove_host_memory(name);
+        std::cout << "✓ A segment not sized yet is waited for like an unready ring" << std::endl;
+    }
+#endif
+
+    // Test channels carry GPS fields, or only inertial values when compact
+    {
+        const char* name = "testchannel_compact";
+        remove_host_memory(name);
+        SharedChannel producer(name, RingOptions(64, 0., false, true));
+        SharedChannel viewer(name);
+        assert(producer.isCompact() && viewer.isCompact() && !viewer.ring().valid());
+        Record gps;
+        gps.lat = 445000000;
+        gps.valid = 1u << POS_LAT;
+        producer.push(gps);
+        producer.push(make_record(2));
+        assert(producer.publish() == 1);
+        Record window[4];
+        uint64_t first;
+        assert(viewer.readLatest(window, 4, first) == 1 && first == 0 && window[0].inertial[0] == 2.f);
+        remove_host_memory(name);
+
+        const char* full = "testchannel_full";
+        remove_host_memory(full);
+        SharedChannel logger(full);
+        assert(!logger.isCompact() && logger.ring().valid());
+        logger.push(gps);
+        logger.publish();
+        assert(logger.readLatest(window, 4, first) == 1 && window[0].isSet(POS_LAT) && std::fabs(window[0].getLat() - 44.5) < 1e-9);
+        remove_host_memory(full);
+        std::cout << "✓ Full channels carry GPS fields, compact ones inertial values" << std::endl;
+    }
+
+    // Test channels on the same name share one mapping, released with the last of them
+    {
+        const char* name = "testchannel_shared";
+        remove_host_memory(name);
+        size_t before = SharedChannel::mappings();
+        {
+            SharedChannel first(name);
+            SharedChannel second(name);
+            SharedChannel copy = first;
+            assert(SharedChannel::mappings() == before + 1);
+            first.ring().push(make_record(3));
+            first.ring().publish();
+            Record record;
+            assert(second.ring().read(0, record) && consistent(record, 3));
+            first.close();
+            assert(!first.isOpen() && copy.isOpen());
+            assert(SharedChannel::mappings() == before + 1);
+        }
+        assert(SharedChannel::mappings() == before);
+        std::cout << "✓ Channels share a mapping and unmap with the last one" << std::endl;
+    }
+
+    // Test reconnecting over and over does not accumulate mappings
+    {
+        const char* name = "testchannel_reconnect";
+        remove_host_memory(name);
+        size_t before = SharedChannel::mappings();
+        SharedChannel producer(name, RingOptions(64));
+        for (int i = 0; i < 10000; i++) {
+            SharedChannel viewer(name);
+            assert(viewer.ring().head() == (uint64_t)i);
+            producer.ring().push(make_record(i));
+            producer.ring().publish();
+            assert(SharedChannel::mappings() == before + 1);
+        }
+        producer.close();
+        assert(SharedChannel::mappings() == before);
+        remove_host_memory(name);
+        std::cout << "✓ Reconnecting keeps the number of mappings bounded" << std::endl;
+    }
+#endif
+
+    std::cout << "All shared channel tests passed!" << std::endl;
+    return 0;
+}
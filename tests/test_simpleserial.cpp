@@ -2,6 +2,10 @@
 #include <cassert>
 #include <iostream>
 #include <stdexcept>
+#if defined(__linux__)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 int main() {
     std::cout << "Testing SimpleSerial class (constructor and basic operations)..." << std::endl;
@@ -66,6 +70,51 @@ int main() {
         }
     }
 
+#if defined(__linux__)
+    // Test buffered reads against a pseudo-terminal standing in for the device
+    {
+        int master = posix_openpt(O_RDWR | O_NOCTTY);
+        assert(master >= 0 && grantpt(master) == 0 && unlockpt(master) == 0);
+        std::string device = ptsname(master);
+        SimpleSerial serial(device, 115200);    // raw mode, before anything is written
+        const std::string lines = "first\r\nsecond\n\nthird\r\n";
+        assert(write(master, lines.data(), lines.size()) == (ssize_t)lines.size());
+        assert(serial.readLine() == "first");
+        assert(serial.readLine() == "second");
+        assert(serial.readLine() == "");
+        assert(serial.readLine() == "third");
+        std::cout << "✓ readLine splits a chunk holding several lines" << std::endl;
+
+        const std::string frames = "0123456789abcdef";
+        SerialOptions options;
+        options.setDevice(device);
+        options.setBaudrate(115200);
+        options.setTimeout(boost::posix_time::seconds(1));
+        SerialDevice port(options);
+        assert(write(master, frames.data(), frames.size()) == (ssize_t)frames.size());
+        std::string received;
+        char small[3];
+        while (received.size() < frames.size()) received.append(small, (size_t)port.read(small, sizeof(small)));
+        assert(received == frames);
+        bool timed_out = false;
+        try { port.read(small, sizeof(small)); } catch (TimeoutException&) { timed_out = true; }
+        assert(timed_out);
+        std::cout << "✓ SerialDevice serves small reads from one chunk and still times out" << std::endl;
+
+        TimeoutSerial timeout_serial(device, 115200);
+        timeout_serial.setTimeout(boost::posix_time::seconds(1));
+        assert(write(master, frames.data(), frames.size()) == (ssize_t)frames.size());
+        assert(timeout_serial.readString(4) == "0123");
+        assert(timeout_serial.readString(10) == "456789abcd");
+        assert(timeout_serial.readString(2) == "ef");
+        timed_out = false;
+        try { timeout_serial.readString(1); } catch (timeout_exception&) { timed_out = true; }
+        assert(timed_out);
+        std::cout << "✓ TimeoutSerial keeps bytes read past the request for the next read" << std::endl;
+        close(master);
+    }
+#endif
+
     std::cout << "SimpleSerial basic interface tests completed!" << std::endl;
     std::cout << "Note: Full functionality testing requires actual serial hardware" << std::endl;
     return 0;
@@ -21,7 +21,15 @@ $TestFiles = @(
     "test_readresult.cpp",
     "test_version.cpp",
     "test_constants.cpp",
-    "test_integration.cpp"
+    "test_integration.cpp",
+    "test_decoders.cpp",
+    "test_checksum.cpp",
+    "test_number_tools.cpp",
+    "test_output_tools.cpp",
+    "test_sample_ring.cpp",
+    "test_shared_channel.cpp",
+    "test_port_reader.cpp",
+    "test_reader_pipeline.cpp"
 )
 
 $AllValid = $true
@@ -112,6 +120,14 @@ $CoverageAreas = @{
     "Enums and Constants" = @("test_readresult.cpp", "test_constants.cpp")
     "Version Management" = @("test_version.cpp")
     "Integration Testing" = @("test_integration.cpp")
+    "Frame Decoders" = @("test_decoders.cpp")
+    "Checksums" = @("test_checksum.cpp")
+    "Number Parsing" = @("test_number_tools.cpp")
+    "Buffered Output" = @("test_output_tools.cpp")
+    "Shared Sample Ring" = @("test_sample_ring.cpp")
+    "Shared Memory Channels" = @("test_shared_channel.cpp")
+    "Multi-Port Acquisition" = @("test_port_reader.cpp")
+    "Pipelined Acquisition" = @("test_reader_pipeline.cpp")
 }
 
 foreach ($area in $CoverageAreas.GetEnumerator()) {
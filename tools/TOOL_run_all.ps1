@@ -4,16 +4,11 @@ $parentPath = (get-item $scriptPath).parent.FullName
 $READER = $parentPath + "\Release\serial_reader.exe"
 $VIEWER = $parentPath + "\Release\serial_viewer.exe"
 
-$META_PARAM = "-t 5 -b 115200 -p COM33"
-$TEXA_PARAM = "-t 3 -b 115200 -p COM35"
-$OCTO_PARAM = "-t 7 -b 115200 -p COM17"
-$MM_2_PARAM = "-t 9 -b 115200 -p COM20"
+# a single reader serves all the boxes
+$READER_PARAM = "-m COM33:115200:5 -m COM35:115200:3 -m COM17:115200:7 -m COM20:115200:9"
 
 Start-Process $VIEWER
 
 Start-Sleep -m 500 # wait for 500 milliseconds
 
-Start-Process $READER $META_PARAM
-Start-Process $READER $TEXA_PARAM
-Start-Process $READER $OCTO_PARAM
-Start-Process $READER $MM_2_PARAM
+Start-Process $READER $READER_PARAM